@@ -193,6 +193,14 @@ bool account_t::remove_post(post_t * post)
   return true;
 }
 
+void account_t::clear_posts()
+{
+  posts.clear();
+
+  foreach (accounts_map::value_type& pair, accounts)
+    pair.second->clear_posts();
+}
+
 string account_t::fullname() const
 {
   if (! _fullname.empty()) {
@@ -372,8 +380,8 @@ namespace {
   }
 
   template <value_t (*Func)(account_t&)>
-  value_t get_wrapper(call_scope_t& args) {
-    return (*Func)(args.context<account_t>());
+  scope_accessor_t<account_t> get_wrapper() {
+    return scope_accessor_t<account_t>(Func);
   }
 
   value_t get_parent(account_t& account) {
@@ -416,13 +424,13 @@ expr_t::ptr_op_t account_t::lookup(const symbol_t::kind_t kind,
   switch (fn_name[0]) {
   case 'a':
     if (fn_name[1] == '\0' || fn_name == "amount")
-      return WRAP_FUNCTOR(get_wrapper<&get_amount>);
+      return WRAP_FUNCTOR(get_wrapper<&get_amount>());
     else if (fn_name == "account")
       return WRAP_FUNCTOR(&get_account);
     else if (fn_name == "account_base")
-      return WRAP_FUNCTOR(get_wrapper<&get_account_base>);
+      return WRAP_FUNCTOR(get_wrapper<&get_account_base>());
     else if (fn_name == "addr")
-      return WRAP_FUNCTOR(get_wrapper<&get_addr>);
+      return WRAP_FUNCTOR(get_wrapper<&get_addr>());
     else if (fn_name == "any")
       return WRAP_FUNCTOR(&fn_any);
     else if (fn_name == "all")
@@ -431,84 +439,84 @@ expr_t::ptr_op_t account_t::lookup(const symbol_t::kind_t kind,
 
   case 'c':
     if (fn_name == "count")
-      return WRAP_FUNCTOR(get_wrapper<&get_count>);
+      return WRAP_FUNCTOR(get_wrapper<&get_count>());
     else if (fn_name == "cost")
-      return WRAP_FUNCTOR(get_wrapper<&get_cost>);
+      return WRAP_FUNCTOR(get_wrapper<&get_cost>());
     break;
 
   case 'd':
     if (fn_name == "depth")
-      return WRAP_FUNCTOR(get_wrapper<&get_depth>);
+      return WRAP_FUNCTOR(get_wrapper<&get_depth>());
     else if (fn_name == "depth_parent")
-      return WRAP_FUNCTOR(get_wrapper<&get_depth_parent>);
+      return WRAP_FUNCTOR(get_wrapper<&get_depth_parent>());
     else if (fn_name == "depth_spacer")
-      return WRAP_FUNCTOR(get_wrapper<&get_depth_spacer>);
+      return WRAP_FUNCTOR(get_wrapper<&get_depth_spacer>());
     break;
 
   case 'e':
     if (fn_name == "earliest")
-      return WRAP_FUNCTOR(get_wrapper<&get_earliest>);
+      return WRAP_FUNCTOR(get_wrapper<&get_earliest>());
     else if (fn_name == "earliest_checkin")
-      return WRAP_FUNCTOR(get_wrapper<&get_earliest_checkin>);
+      return WRAP_FUNCTOR(get_wrapper<&get_earliest_checkin>());
     break;
 
   case 'i':
     if (fn_name == "is_account")
-      return WRAP_FUNCTOR(get_wrapper<&get_true>);
+      return WRAP_FUNCTOR(get_wrapper<&get_true>());
     else if (fn_name == "is_index")
-      return WRAP_FUNCTOR(get_wrapper<&get_subcount>);
+      return WRAP_FUNCTOR(get_wrapper<&get_subcount>());
     break;
 
   case 'l':
     if (fn_name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_depth>);
+      return WRAP_FUNCTOR(get_wrapper<&get_depth>());
     else if (fn_name == "latest_cleared")
-      return WRAP_FUNCTOR(get_wrapper<&get_latest_cleared>);
+      return WRAP_FUNCTOR(get_wrapper<&get_latest_cleared>());
     else if (fn_name == "latest")
-      return WRAP_FUNCTOR(get_wrapper<&get_latest>);
+      return WRAP_FUNCTOR(get_wrapper<&get_latest>());
     else if (fn_name == "latest_checkout")
-      return WRAP_FUNCTOR(get_wrapper<&get_latest_checkout>);
+      return WRAP_FUNCTOR(get_wrapper<&get_latest_checkout>());
     else if (fn_name == "latest_checkout_cleared")
-      return WRAP_FUNCTOR(get_wrapper<&get_latest_checkout_cleared>);
+      return WRAP_FUNCTOR(get_wrapper<&get_latest_checkout_cleared>());
     break;
 
   case 'n':
     if (fn_name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_subcount>);
+      return WRAP_FUNCTOR(get_wrapper<&get_subcount>());
     else if (fn_name == "note")
-      return WRAP_FUNCTOR(get_wrapper<&get_note>);
+      return WRAP_FUNCTOR(get_wrapper<&get_note>());
     break;
 
   case 'p':
     if (fn_name == "partial_account")
       return WRAP_FUNCTOR(get_partial_name);
     else if (fn_name == "parent")
-      return WRAP_FUNCTOR(get_wrapper<&get_parent>);
+      return WRAP_FUNCTOR(get_wrapper<&get_parent>());
     break;
 
   case 's':
     if (fn_name == "subcount")
-      return WRAP_FUNCTOR(get_wrapper<&get_subcount>);
+      return WRAP_FUNCTOR(get_wrapper<&get_subcount>());
     break;
 
   case 't':
     if (fn_name == "total")
-      return WRAP_FUNCTOR(get_wrapper<&get_total>);
+      return WRAP_FUNCTOR(get_wrapper<&get_total>());
     break;
 
   case 'u':
     if (fn_name == "use_direct_amount")
-      return WRAP_FUNCTOR(get_wrapper<&ignore>);
+      return WRAP_FUNCTOR(get_wrapper<&ignore>());
     break;
 
   case 'N':
     if (fn_name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_count>);
+      return WRAP_FUNCTOR(get_wrapper<&get_count>());
     break;
 
   case 'O':
     if (fn_name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_total>);
+      return WRAP_FUNCTOR(get_wrapper<&get_total>());
     break;
   }
 
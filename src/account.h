@@ -141,6 +141,7 @@ public:
   void add_deferred_post(const string& uuid, post_t * post);
   void apply_deferred_posts();
   bool remove_post(post_t * post);
+  void clear_posts();
 
   posts_list::iterator posts_begin() {
     return posts.begin();
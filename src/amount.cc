@@ -36,49 +36,229 @@
 #include "commodity.h"
 #include "annotate.h"
 #include "pool.h"
+#include "pstream.h"
 
 namespace ledger {
 
 bool amount_t::stream_fullstrings = false;
 
-#if !defined(THREADSAFE)
-// These global temporaries are pre-initialized for the sake of
-// efficiency, and are reused over and over again.
-static mpz_t  temp;
-static mpq_t  tempq;
-static mpfr_t tempf;
-static mpfr_t tempfb;
-static mpfr_t tempfnum;
-static mpfr_t tempfden;
-#endif
+namespace {
+  // These temporaries are pre-initialized for the sake of efficiency, and
+  // are reused over and over again.  Each thread has its own set, so that
+  // amounts may be operated on from several threads at once.
+  struct scratch_t
+  {
+    mpz_t  temp;
+    mpq_t  tempq;
+    mpq_t  tempv;
+    mpq_t  tempvb;
+    mpfr_t tempf;
+    mpfr_t tempfb;
+    mpfr_t tempfnum;
+    mpfr_t tempfden;
+
+    scratch_t() {
+      mpz_init(temp);
+      mpq_init(tempq);
+      mpq_init(tempv);
+      mpq_init(tempvb);
+      mpfr_init(tempf);
+      mpfr_init(tempfb);
+      mpfr_init(tempfnum);
+      mpfr_init(tempfden);
+    }
+    ~scratch_t() {
+      mpz_clear(temp);
+      mpq_clear(tempq);
+      mpq_clear(tempv);
+      mpq_clear(tempvb);
+      mpfr_clear(tempf);
+      mpfr_clear(tempfb);
+      mpfr_clear(tempfnum);
+      mpfr_clear(tempfden);
+    }
+  };
+
+  scratch_t& scratch()
+  {
+    static thread_local scratch_t values;
+    return values;
+  }
+}
+
+namespace {
+  // The largest number of decimal places a small quantity may have, so
+  // that its scale factor still fits in 64 bits.
+  const amount_t::precision_t max_small_scale = 18;
+
+  const int64_t powers_of_ten[max_small_scale + 1] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+    100000000LL, 1000000000LL, 10000000000LL, 100000000000LL,
+    1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+    1000000000000000000LL
+  };
+
+  const int64_t small_max = std::numeric_limits<int64_t>::max();
+  const int64_t small_min = std::numeric_limits<int64_t>::min();
+
+  // Each of these returns false, leaving RESULT alone, if the answer
+  // would not fit in 64 bits.
+
+  bool small_add(int64_t a, int64_t b, int64_t& result)
+  {
+    if ((b > 0 && a > small_max - b) || (b < 0 && a < small_min - b))
+      return false;
+    result = a + b;
+    return true;
+  }
+
+  bool small_subtract(int64_t a, int64_t b, int64_t& result)
+  {
+    if ((b < 0 && a > small_max + b) || (b > 0 && a < small_min + b))
+      return false;
+    result = a - b;
+    return true;
+  }
+
+  bool small_multiply(int64_t a, int64_t b, int64_t& result)
+  {
+    if (a > 0) {
+      if (b > 0 ? a > small_max / b : b < small_min / a)
+        return false;
+    } else if (a < 0) {
+      if (b > 0 ? a < small_min / b : b < small_max / a)
+        return false;
+    }
+    result = a * b;
+    return true;
+  }
+
+  bool small_shift(int64_t a, amount_t::precision_t places, int64_t& result)
+  {
+    return (places <= max_small_scale &&
+            small_multiply(a, powers_of_ten[places], result));
+  }
+
+  // Bring A and B to the same scale, the larger of the two.
+  bool small_align(int64_t& a, amount_t::precision_t a_scale,
+                   int64_t& b, amount_t::precision_t b_scale,
+                   amount_t::precision_t& scale)
+  {
+    if (a_scale < b_scale) {
+      if (! small_shift(a, static_cast<amount_t::precision_t>
+                        (b_scale - a_scale), a))
+        return false;
+      scale = b_scale;
+    } else {
+      if (! small_shift(b, static_cast<amount_t::precision_t>
+                        (a_scale - b_scale), b))
+        return false;
+      scale = a_scale;
+    }
+    return true;
+  }
+
+  void small_to_mpq(mpq_ptr dest, int64_t num, amount_t::precision_t scale)
+  {
+    if (num >= std::numeric_limits<long>::min() &&
+        num <= std::numeric_limits<long>::max()) {
+      mpz_set_si(mpq_numref(dest), static_cast<long>(num));
+    } else {
+      // mpz_set_si takes a long, which may be narrower than 64 bits.
+      uint64_t magnitude = (num < 0 ? uint64_t(0) - static_cast<uint64_t>(num)
+                            : static_cast<uint64_t>(num));
+      mpz_import(mpq_numref(dest), 1, 1, sizeof(magnitude), 0, 0,
+                 &magnitude);
+      if (num < 0)
+        mpz_neg(mpq_numref(dest), mpq_numref(dest));
+    }
+    mpz_ui_pow_ui(mpq_denref(dest), 10, scale);
+    mpq_canonicalize(dest);
+  }
+}
 
 struct amount_t::bigint_t : public supports_flags<>
 {
 #define BIGINT_BULK_ALLOC 0x01
 #define BIGINT_KEEP_PREC  0x02
+#define BIGINT_SMALL      0x04
 
   mpq_t          val;
   precision_t    prec;
-  uint_least32_t refc;
 
-#define MP(bigint) ((bigint)->val)
+  // Copies of an amount share its quantity, and those copies may be
+  // handed to other threads, so the count is kept atomically.
+  std::atomic<uint_least32_t> refc;
+
+  // Most quantities are decimal numbers whose digits fit in 64 bits.
+  // These are kept exactly as SCALED / 10^SCALE, with BIGINT_SMALL set and
+  // VAL left uninitialized, so that adding and comparing them needs no
+  // calls into GMP.  They are promoted to a rational the first time an
+  // operation needs one.
+  int64_t        scaled;
+  precision_t    scale;
+
+#define MP(bigint) ((bigint)->rational())
 
-  bigint_t() : prec(0), refc(1) {
+  bigint_t() : prec(0), refc(1), scaled(0), scale(0) {
     mpq_init(val);
     TRACE_CTOR(bigint_t, "");
   }
+  bigint_t(int64_t _scaled, precision_t _scale)
+    : supports_flags<>(BIGINT_SMALL), prec(_scale), refc(1),
+      scaled(_scaled), scale(_scale) {
+    TRACE_CTOR(bigint_t, "int64_t, precision_t");
+  }
   bigint_t(const bigint_t& other)
     : supports_flags<>(static_cast<uint_least8_t>
                        (other.flags() & ~BIGINT_BULK_ALLOC)),
-      prec(other.prec), refc(1) {
-    mpq_init(val);
-    mpq_set(val, other.val);
+      prec(other.prec), refc(1), scaled(other.scaled), scale(other.scale) {
+    if (! other.has_flags(BIGINT_SMALL)) {
+      mpq_init(val);
+      mpq_set(val, other.val);
+    }
     TRACE_CTOR(bigint_t, "copy");
   }
   ~bigint_t() {
     TRACE_DTOR(bigint_t);
     assert(refc == 0);
-    mpq_clear(val);
+    if (! has_flags(BIGINT_SMALL))
+      mpq_clear(val);
+  }
+
+  bool is_small() const {
+    return has_flags(BIGINT_SMALL);
+  }
+
+  void set_small(int64_t num, precision_t places) {
+    if (! has_flags(BIGINT_SMALL)) {
+      mpq_clear(val);
+      add_flags(BIGINT_SMALL);
+    }
+    scaled = num;
+    scale = places;
+  }
+
+  // Return the value as a rational that may be changed, promoting a
+  // small quantity if need be.
+  mpq_ptr rational() {
+    if (has_flags(BIGINT_SMALL)) {
+      mpq_init(val);
+      small_to_mpq(val, scaled, scale);
+      drop_flags(BIGINT_SMALL);
+    }
+    return val;
+  }
+
+  // Return the value as a rational only to be read.  A small quantity is
+  // converted into SCRATCH, rather than being promoted for good.
+  mpq_srcptr rational(mpq_ptr scratch) const {
+    if (has_flags(BIGINT_SMALL)) {
+      small_to_mpq(scratch, scaled, scale);
+      return scratch;
+    }
+    return val;
   }
 
   bool valid() const {
@@ -86,9 +266,13 @@ struct amount_t::bigint_t : public supports_flags<>
       DEBUG("ledger.validate", "amount_t::bigint_t: prec > 1024");
       return false;
     }
-    if (flags() & ~(BIGINT_BULK_ALLOC | BIGINT_KEEP_PREC)) {
+    if (flags() & ~(BIGINT_BULK_ALLOC | BIGINT_KEEP_PREC | BIGINT_SMALL)) {
       DEBUG("ledger.validate",
-            "amount_t::bigint_t: flags() & ~(BULK_ALLOC | KEEP_PREC)");
+            "amount_t::bigint_t: flags() & ~(BULK_ALLOC | KEEP_PREC | SMALL)");
+      return false;
+    }
+    if (has_flags(BIGINT_SMALL) && scale > max_small_scale) {
+      DEBUG("ledger.validate", "amount_t::bigint_t: scale > max_small_scale");
       return false;
     }
     return true;
@@ -99,7 +283,7 @@ bool amount_t::is_initialized = false;
 
 namespace {
   void stream_out_mpq(std::ostream&                 out,
-                      mpq_t                         quant,
+                      mpq_srcptr                    quant,
                       amount_t::precision_t         precision,
                       int                           zeros_prec = -1,
                       mpfr_rnd_t                    rnd        = GMP_RNDN,
@@ -125,8 +309,9 @@ namespace {
         num_prec = MPFR_PREC_MIN;
       DEBUG("amount.convert", "num prec = " << num_prec);
 
-      mpfr_set_prec(tempfnum, num_prec);
-      mpfr_set_z(tempfnum, mpq_numref(quant), rnd);
+      scratch_t& s(scratch());
+      mpfr_set_prec(s.tempfnum, num_prec);
+      mpfr_set_z(s.tempfnum, mpq_numref(quant), rnd);
 
       mp_prec_t den_prec =
         static_cast<mpfr_prec_t>(mpz_sizeinbase(mpq_denref(quant), 2));
@@ -135,13 +320,13 @@ namespace {
         den_prec = MPFR_PREC_MIN;
       DEBUG("amount.convert", "den prec = " << den_prec);
 
-      mpfr_set_prec(tempfden, den_prec);
-      mpfr_set_z(tempfden, mpq_denref(quant), rnd);
+      mpfr_set_prec(s.tempfden, den_prec);
+      mpfr_set_z(s.tempfden, mpq_denref(quant), rnd);
 
-      mpfr_set_prec(tempfb, num_prec + den_prec);
-      mpfr_div(tempfb, tempfnum, tempfden, rnd);
+      mpfr_set_prec(s.tempfb, num_prec + den_prec);
+      mpfr_div(s.tempfb, s.tempfnum, s.tempfden, rnd);
 
-      if (mpfr_asprintf(&buf, "%.*RNf", precision, tempfb) < 0)
+      if (mpfr_asprintf(&buf, "%.*RNf", precision, s.tempfb) < 0)
         throw_(amount_error,
                _("Cannot output amount to a floating-point representation"));
 
@@ -227,13 +412,6 @@ namespace {
 void amount_t::initialize()
 {
   if (! is_initialized) {
-    mpz_init(temp);
-    mpq_init(tempq);
-    mpfr_init(tempf);
-    mpfr_init(tempfb);
-    mpfr_init(tempfnum);
-    mpfr_init(tempfden);
-
     commodity_pool_t::current_pool.reset(new commodity_pool_t);
 
     // Add time commodity conversions, so that timelog's may be parsed
@@ -260,13 +438,6 @@ void amount_t::initialize()
 void amount_t::shutdown()
 {
   if (is_initialized) {
-    mpz_clear(temp);
-    mpq_clear(tempq);
-    mpfr_clear(tempf);
-    mpfr_clear(tempfb);
-    mpfr_clear(tempfnum);
-    mpfr_clear(tempfden);
-
     commodity_pool_t::current_pool.reset();
 
     is_initialized = false;
@@ -350,15 +521,18 @@ amount_t::amount_t(const double val) : commodity_(NULL)
 
 amount_t::amount_t(const unsigned long val) : commodity_(NULL)
 {
-  quantity = new bigint_t;
-  mpq_set_ui(MP(quantity), val, 1);
+  if (static_cast<uint64_t>(val) <= static_cast<uint64_t>(small_max)) {
+    quantity = new bigint_t(static_cast<int64_t>(val), 0);
+  } else {
+    quantity = new bigint_t;
+    mpq_set_ui(MP(quantity), val, 1);
+  }
   TRACE_CTOR(amount_t, "const unsigned long");
 }
 
 amount_t::amount_t(const long val) : commodity_(NULL)
 {
-  quantity = new bigint_t;
-  mpq_set_si(MP(quantity), val, 1);
+  quantity = new bigint_t(val, 0);
   TRACE_CTOR(amount_t, "const long");
 }
 
@@ -394,7 +568,17 @@ int amount_t::compare(const amount_t& amt) const
            % commodity() % amt.commodity());
   }
 
-  return mpq_cmp(MP(quantity), MP(amt.quantity));
+  if (quantity->is_small() && amt.quantity->is_small()) {
+    int64_t     a = quantity->scaled;
+    int64_t     b = amt.quantity->scaled;
+    precision_t scale;
+    if (small_align(a, quantity->scale, b, amt.quantity->scale, scale))
+      return a < b ? -1 : (a > b ? 1 : 0);
+  }
+
+  scratch_t& s(scratch());
+  return mpq_cmp(quantity->rational(s.tempv),
+                 amt.quantity->rational(s.tempvb));
 }
 
 bool amount_t::operator==(const amount_t& amt) const
@@ -406,7 +590,17 @@ bool amount_t::operator==(const amount_t& amt) const
   else if (commodity() != amt.commodity())
     return false;
 
-  return mpq_equal(MP(quantity), MP(amt.quantity));
+  if (quantity->is_small() && amt.quantity->is_small()) {
+    int64_t     a = quantity->scaled;
+    int64_t     b = amt.quantity->scaled;
+    precision_t scale;
+    if (small_align(a, quantity->scale, b, amt.quantity->scale, scale))
+      return a == b;
+  }
+
+  scratch_t& s(scratch());
+  return mpq_equal(quantity->rational(s.tempv),
+                   amt.quantity->rational(s.tempvb));
 }
 
 
@@ -431,7 +625,20 @@ amount_t& amount_t::operator+=(const amount_t& amt)
 
   _dup();
 
-  mpq_add(MP(quantity), MP(quantity), MP(amt.quantity));
+  bool done = false;
+  if (quantity->is_small() && amt.quantity->is_small()) {
+    int64_t     a = quantity->scaled;
+    int64_t     b = amt.quantity->scaled;
+    precision_t scale;
+    if (small_align(a, quantity->scale, b, amt.quantity->scale, scale) &&
+        small_add(a, b, a)) {
+      quantity->set_small(a, scale);
+      done = true;
+    }
+  }
+  if (! done)
+    mpq_add(MP(quantity), MP(quantity),
+            amt.quantity->rational(scratch().tempv));
 
   if (has_commodity() == amt.has_commodity())
     if (quantity->prec < amt.quantity->prec)
@@ -461,7 +668,20 @@ amount_t& amount_t::operator-=(const amount_t& amt)
 
   _dup();
 
-  mpq_sub(MP(quantity), MP(quantity), MP(amt.quantity));
+  bool done = false;
+  if (quantity->is_small() && amt.quantity->is_small()) {
+    int64_t     a = quantity->scaled;
+    int64_t     b = amt.quantity->scaled;
+    precision_t scale;
+    if (small_align(a, quantity->scale, b, amt.quantity->scale, scale) &&
+        small_subtract(a, b, a)) {
+      quantity->set_small(a, scale);
+      done = true;
+    }
+  }
+  if (! done)
+    mpq_sub(MP(quantity), MP(quantity),
+            amt.quantity->rational(scratch().tempv));
 
   if (has_commodity() == amt.has_commodity())
     if (quantity->prec < amt.quantity->prec)
@@ -485,7 +705,19 @@ amount_t& amount_t::multiply(const amount_t& amt, bool ignore_commodity)
 
   _dup();
 
-  mpq_mul(MP(quantity), MP(quantity), MP(amt.quantity));
+  bool done = false;
+  if (quantity->is_small() && amt.quantity->is_small() &&
+      quantity->scale + amt.quantity->scale <= max_small_scale) {
+    int64_t product;
+    if (small_multiply(quantity->scaled, amt.quantity->scaled, product)) {
+      quantity->set_small(product, static_cast<precision_t>
+                          (quantity->scale + amt.quantity->scale));
+      done = true;
+    }
+  }
+  if (! done)
+    mpq_mul(MP(quantity), MP(quantity),
+            amt.quantity->rational(scratch().tempv));
   quantity->prec =
     static_cast<precision_t>(quantity->prec + amt.quantity->prec);
 
@@ -522,7 +754,38 @@ amount_t& amount_t::operator/=(const amount_t& amt)
   // Increase the value's precision, to capture fractional parts after
   // the divide.  Round up in the last position.
 
-  mpq_div(MP(quantity), MP(quantity), MP(amt.quantity));
+  bool done = false;
+  if (quantity->is_small() && amt.quantity->is_small()) {
+    // The quotient stays small only if it is an exact decimal, which is
+    // found by shifting the dividend left until the divisor goes into it.
+    int64_t divisor = amt.quantity->scaled;
+    for (precision_t places = 0; places <= max_small_scale; places++) {
+      int64_t dividend;
+      if (! small_shift(quantity->scaled, places, dividend) ||
+          (divisor == -1 && dividend == small_min))
+        break;
+      if (dividend % divisor != 0)
+        continue;
+
+      int64_t quotient = dividend / divisor;
+      int     scale    = (int(quantity->scale) + int(places) -
+                          int(amt.quantity->scale));
+      if (scale < 0) {
+        if (! small_shift(quotient, static_cast<precision_t>(-scale),
+                          quotient))
+          break;
+        scale = 0;
+      }
+      if (scale <= int(max_small_scale)) {
+        quantity->set_small(quotient, static_cast<precision_t>(scale));
+        done = true;
+      }
+      break;
+    }
+  }
+  if (! done)
+    mpq_div(MP(quantity), MP(quantity),
+            amt.quantity->rational(scratch().tempv));
   quantity->prec =
     static_cast<precision_t>(quantity->prec + amt.quantity->prec +
                              extend_by_digits);
@@ -592,7 +855,10 @@ void amount_t::in_place_negate()
 {
   if (quantity) {
     _dup();
-    mpq_neg(MP(quantity), MP(quantity));
+    if (quantity->is_small() && quantity->scaled != small_min)
+      quantity->scaled = - quantity->scaled;
+    else
+      mpq_neg(MP(quantity), MP(quantity));
   } else {
     throw_(amount_error, _("Cannot negate an uninitialized amount"));
   }
@@ -644,9 +910,10 @@ void amount_t::in_place_truncate()
 
   mpq_set_str(MP(quantity), buf.get(), 10);
 
-  mpz_ui_pow_ui(temp, 10, display_precision());
-  mpq_set_z(tempq, temp);
-  mpq_div(MP(quantity), MP(quantity), tempq);
+  scratch_t& s(scratch());
+  mpz_ui_pow_ui(s.temp, 10, display_precision());
+  mpq_set_z(s.tempq, s.temp);
+  mpq_div(MP(quantity), MP(quantity), s.tempq);
 
   DEBUG("amount.truncate", "Truncated = " << *this);
 #else
@@ -663,8 +930,9 @@ void amount_t::in_place_floor()
 
   _dup();
 
-  mpz_fdiv_q(temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
-  mpq_set_z(MP(quantity), temp);
+  scratch_t& s(scratch());
+  mpz_fdiv_q(s.temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
+  mpq_set_z(MP(quantity), s.temp);
 }
 
 void amount_t::in_place_ceiling()
@@ -674,8 +942,9 @@ void amount_t::in_place_ceiling()
 
   _dup();
 
-  mpz_cdiv_q(temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
-  mpq_set_z(MP(quantity), temp);
+  scratch_t& s(scratch());
+  mpz_cdiv_q(s.temp,  mpq_numref(MP(quantity)), mpq_denref(MP(quantity)));
+  mpq_set_z(MP(quantity), s.temp);
 }
 
 void amount_t::in_place_roundto(int places)
@@ -822,6 +1091,9 @@ int amount_t::sign() const
   if (! quantity)
     throw_(amount_error, _("Cannot determine sign of an uninitialized amount"));
 
+  if (quantity->is_small())
+    return quantity->scaled > 0 ? 1 : (quantity->scaled < 0 ? -1 : 0);
+
   return mpq_sgn(MP(quantity));
 }
 
@@ -837,8 +1109,27 @@ bool amount_t::is_zero() const
     else if (is_realzero()) {
       return true;
     }
-    else if (mpz_cmp(mpq_numref(MP(quantity)),
-                     mpq_denref(MP(quantity))) > 0) {
+    else if (quantity->is_small()) {
+      // The amount displays as zero if it is less than half of the last
+      // place shown.  An amount of exactly one half is printed instead,
+      // so that it is rounded just as it would be for display.
+      precision_t places = commodity().precision();
+      if (quantity->scale <= places)
+        return false;
+      if (quantity->scale - places <= max_small_scale) {
+        uint64_t magnitude =
+          (quantity->scaled < 0 ?
+           uint64_t(0) - static_cast<uint64_t>(quantity->scaled) :
+           static_cast<uint64_t>(quantity->scaled));
+        uint64_t half =
+          static_cast<uint64_t>(powers_of_ten[quantity->scale - places]) / 2;
+        if (magnitude != half)
+          return magnitude < half;
+      }
+    }
+
+    mpq_srcptr quant = quantity->rational(scratch().tempv);
+    if (mpz_cmp(mpq_numref(quant), mpq_denref(quant)) > 0) {
       DEBUG("amount.is_zero", "Numerator is larger than the denominator");
       return false;
     }
@@ -846,7 +1137,7 @@ bool amount_t::is_zero() const
       DEBUG("amount.is_zero", "We have to print the number to check for zero");
 
       std::ostringstream out;
-      stream_out_mpq(out, MP(quantity), commodity().precision());
+      stream_out_mpq(out, quant, commodity().precision());
 
       string output = out.str();
       if (! output.empty()) {
@@ -866,8 +1157,9 @@ double amount_t::to_double() const
   if (! quantity)
     throw_(amount_error, _("Cannot convert an uninitialized amount to a double"));
 
-  mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
-  return mpfr_get_d(tempf, GMP_RNDN);
+  scratch_t& s(scratch());
+  mpfr_set_q(s.tempf, quantity->rational(s.tempv), GMP_RNDN);
+  return mpfr_get_d(s.tempf, GMP_RNDN);
 }
 
 long amount_t::to_long() const
@@ -875,14 +1167,16 @@ long amount_t::to_long() const
   if (! quantity)
     throw_(amount_error, _("Cannot convert an uninitialized amount to a long"));
 
-  mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
-  return mpfr_get_si(tempf, GMP_RNDN);
+  scratch_t& s(scratch());
+  mpfr_set_q(s.tempf, quantity->rational(s.tempv), GMP_RNDN);
+  return mpfr_get_si(s.tempf, GMP_RNDN);
 }
 
 bool amount_t::fits_in_long() const
 {
-  mpfr_set_q(tempf, MP(quantity), GMP_RNDN);
-  return mpfr_fits_slong_p(tempf, GMP_RNDN);
+  scratch_t& s(scratch());
+  mpfr_set_q(s.tempf, quantity->rational(s.tempv), GMP_RNDN);
+  return mpfr_fits_slong_p(s.tempf, GMP_RNDN);
 }
 
 commodity_t * amount_t::commodity_ptr() const
@@ -1039,6 +1333,113 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
     }
   }
 
+  return _parse(quant, symbol, details, negative, comm_flags, flags);
+}
+
+namespace {
+  const char * skip_spaces(const char * p, const char * end)
+  {
+    while (p < end && std::isspace(*p))
+      p++;
+    return p;
+  }
+
+  // Reads a quantity as parse_quantity does.  Returns false for
+  // quantities too long for it to read in one go.
+  bool scan_quantity(const char *& p, const char * end, string& value)
+  {
+    const char * q     = skip_spaces(p, end);
+    const char * start = q;
+    while (q < end && (std::isdigit(*q) || *q == '-' || *q == '.' ||
+                       *q == ','))
+      q++;
+    if (q - start >= 255)
+      return false;
+
+    while (q > start && ! std::isdigit(*(q - 1)))
+      q--;
+
+    value.assign(start, static_cast<string::size_type>(q - start));
+    p = q;
+    return true;
+  }
+
+  bool at_annotation(const char * p, const char * end)
+  {
+    p = skip_spaces(p, end);
+    return p < end && (*p == '{' || *p == '[' || *p == '(');
+  }
+}
+
+bool amount_t::parse(const char * str, std::size_t len, std::size_t& consumed,
+                     const parse_flags_t& flags)
+{
+  // This reads the same syntax as parse(std::istream&), straight from
+  // memory.  Whatever it does not handle itself, such as quoted symbols
+  // and annotations, is passed on to the stream version.
+
+  const char * end = str + len;
+  const char * p   = skip_spaces(str, end);
+
+  string       symbol;
+  string       quant;
+  annotation_t details;
+  bool         negative = false;
+  bool         simple   = true;
+
+  commodity_t::flags_t comm_flags = COMMODITY_STYLE_DEFAULTS;
+
+  if (p < end && *p == '-') {
+    negative = true;
+    p = skip_spaces(p + 1, end);
+  }
+
+  if (p < end && std::isdigit(*p)) {
+    simple = scan_quantity(p, end, quant);
+
+    if (simple && p < end && *p != '\n') {
+      if (std::isspace(*p))
+        comm_flags |= COMMODITY_STYLE_SEPARATED;
+
+      simple = commodity_t::scan_symbol(p, end, symbol);
+
+      if (! symbol.empty())
+        comm_flags |= COMMODITY_STYLE_SUFFIXED;
+
+      if (simple && ! flags.has_flags(PARSE_NO_ANNOT) &&
+          p < end && *p != '\n' && at_annotation(p, end))
+        simple = false;
+    }
+  } else {
+    simple = commodity_t::scan_symbol(p, end, symbol);
+
+    if (simple && p < end && *p != '\n') {
+      if (std::isspace(*p))
+        comm_flags |= COMMODITY_STYLE_SEPARATED;
+
+      simple = scan_quantity(p, end, quant);
+
+      if (simple && ! flags.has_flags(PARSE_NO_ANNOT) && ! quant.empty() &&
+          p < end && *p != '\n' && at_annotation(p, end))
+        simple = false;
+    }
+  }
+
+  if (! simple) {
+    ptristream stream(const_cast<char *>(str), len);
+    bool result = parse(stream, flags);
+    consumed = stream.eof() ? len : static_cast<std::size_t>(stream.tellg());
+    return result;
+  }
+
+  consumed = static_cast<std::size_t>(p - str);
+  return _parse(quant, symbol, details, negative, comm_flags, flags);
+}
+
+bool amount_t::_parse(const string& quant, const string& symbol,
+                      annotation_t& details, bool negative,
+                      uint_least16_t comm_flags, const parse_flags_t& flags)
+{
   if (quant.empty()) {
     if (flags.has_flags(PARSE_SOFT_FAIL))
       return false;
@@ -1063,7 +1464,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
   }
 
   if (! new_quantity.get())
-    new_quantity.reset(new bigint_t);
+    new_quantity.reset(new bigint_t(0, 0));
 
   // No one is holding a reference to this now.
   new_quantity->refc--;
@@ -1182,9 +1583,30 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
       commodity().set_precision(new_quantity->prec);
   }
 
-  // Now we have the final number.  Remove commas and periods, if necessary.
+  // Now we have the final number.  If its digits fit in 64 bits, which is
+  // nearly always, it is kept as a small quantity.
+
+  int64_t     digits_value = 0;
+  std::size_t digits       = 0;
+  bool        fits         = new_quantity->prec <= max_small_scale;
+  for (const char * p = quant.c_str(); fits && *p; p++) {
+    if (std::isdigit(static_cast<unsigned char>(*p))) {
+      if (++digits > max_small_scale)
+        fits = false;
+      else
+        digits_value = digits_value * 10 + (*p - '0');
+    }
+    else if (*p != ',' && *p != '.') {
+      fits = false;
+    }
+  }
 
-  if (last_comma != string::npos || last_period != string::npos) {
+  if (fits) {
+    new_quantity->set_small(negative ? - digits_value : digits_value,
+                            new_quantity->prec);
+  }
+  // Otherwise remove commas and periods, if necessary.
+  else if (last_comma != string::npos || last_period != string::npos) {
     string::size_type  len = quant.length();
     scoped_array<char> buf(new char[len + 1]);
     const char *       p   = quant.c_str();
@@ -1198,9 +1620,10 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
     *t = '\0';
 
     mpq_set_str(MP(new_quantity.get()), buf.get(), 10);
-    mpz_ui_pow_ui(temp, 10, new_quantity->prec);
-    mpq_set_z(tempq, temp);
-    mpq_div(MP(new_quantity.get()), MP(new_quantity.get()), tempq);
+    scratch_t& s(scratch());
+    mpz_ui_pow_ui(s.temp, 10, new_quantity->prec);
+    mpq_set_z(s.tempq, s.temp);
+    mpq_div(MP(new_quantity.get()), MP(new_quantity.get()), s.tempq);
 
     IF_DEBUG("amount.parse") {
       char * amt_buf = mpq_get_str(NULL, 10, MP(new_quantity.get()));
@@ -1211,7 +1634,7 @@ bool amount_t::parse(std::istream& in, const parse_flags_t& flags)
     mpq_set_str(MP(new_quantity.get()), quant.c_str(), 10);
   }
 
-  if (negative)
+  if (negative && ! new_quantity->is_small())
     mpq_neg(MP(new_quantity.get()), MP(new_quantity.get()));
 
   new_quantity->refc++;
@@ -1271,7 +1694,7 @@ void amount_t::print(std::ostream& _out, const uint_least8_t flags) const
       out << " ";
   }
 
-  stream_out_mpq(out, MP(quantity), display_precision(),
+  stream_out_mpq(out, quantity->rational(scratch().tempv), display_precision(),
                  comm ? commodity().precision() : 0, GMP_RNDN, comm);
 
   if (comm.has_flags(COMMODITY_STYLE_SUFFIXED)) {
@@ -1290,6 +1713,125 @@ void amount_t::print(std::ostream& _out, const uint_least8_t flags) const
   _out << out.str();
 }
 
+namespace {
+  template <typename T>
+  void write_binary(std::ostream& out, const T& num) {
+    out.write(reinterpret_cast<const char *>(&num), sizeof(T));
+  }
+
+  template <typename T>
+  void read_binary(const char *& data, const char * end, T& num) {
+    if (end - data < static_cast<std::ptrdiff_t>(sizeof(T)))
+      throw_(amount_error, _("Truncated amount data"));
+    std::memcpy(&num, data, sizeof(T));
+    data += sizeof(T);
+  }
+
+  void write_mpz(std::ostream& out, mpz_srcptr num)
+  {
+    uint32_t size = 0;
+    if (mpz_sgn(num) != 0)
+      size = static_cast<uint32_t>((mpz_sizeinbase(num, 2) + 7) / 8);
+    write_binary(out, size);
+
+    if (size > 0) {
+      std::vector<char> buf(size);
+      std::size_t       count;
+      mpz_export(&buf[0], &count, 1, 1, 0, 0, num);
+      assert(count == size);
+      out.write(&buf[0], size);
+    }
+  }
+
+  void read_mpz(const char *& data, const char * end, mpz_ptr num)
+  {
+    uint32_t size;
+    read_binary(data, end, size);
+    if (end - data < static_cast<std::ptrdiff_t>(size))
+      throw_(amount_error, _("Truncated amount data"));
+
+    if (size > 0)
+      mpz_import(num, size, 1, 1, 0, 0, data);
+    else
+      mpz_set_ui(num, 0);
+    data += size;
+  }
+}
+
+void amount_t::write_quantity(std::ostream& out) const
+{
+  VERIFY(valid());
+
+  // The kind of quantity written: none, a rational, or a small quantity.
+  uint8_t kind = ! quantity ? 0 : (quantity->is_small() ? 2 : 1);
+  write_binary(out, kind);
+  if (! quantity)
+    return;
+
+  uint8_t keep_prec = quantity->has_flags(BIGINT_KEEP_PREC) ? 1 : 0;
+  write_binary(out, quantity->prec);
+  write_binary(out, keep_prec);
+
+  if (quantity->is_small()) {
+    write_binary(out, quantity->scaled);
+    write_binary(out, quantity->scale);
+    return;
+  }
+
+  uint8_t negative = mpq_sgn(quantity->val) < 0 ? 1 : 0;
+  write_binary(out, negative);
+
+  // mpz_export writes only the magnitude, which is why the sign is kept
+  // separately above.
+  write_mpz(out, mpq_numref(quantity->val));
+  write_mpz(out, mpq_denref(quantity->val));
+}
+
+void amount_t::read_quantity(const char *& data, const char * end)
+{
+  _clear();
+
+  uint8_t kind;
+  read_binary(data, end, kind);
+  if (kind == 0)
+    return;
+  if (kind > 2)
+    throw_(amount_error, _("Invalid amount data"));
+
+  quantity = new bigint_t(0, 0);
+  try {
+    uint8_t keep_prec;
+    read_binary(data, end, quantity->prec);
+    read_binary(data, end, keep_prec);
+
+    if (kind == 2) {
+      read_binary(data, end, quantity->scaled);
+      read_binary(data, end, quantity->scale);
+      if (quantity->scale > max_small_scale)
+        throw_(amount_error, _("Invalid amount data"));
+    } else {
+      uint8_t negative;
+      read_binary(data, end, negative);
+
+      read_mpz(data, end, mpq_numref(MP(quantity)));
+      read_mpz(data, end, mpq_denref(MP(quantity)));
+      if (mpz_sgn(mpq_denref(MP(quantity))) == 0)
+        throw_(amount_error, _("Invalid amount data"));
+      if (negative)
+        mpz_neg(mpq_numref(MP(quantity)), mpq_numref(MP(quantity)));
+    }
+
+    if (keep_prec)
+      quantity->add_flags(BIGINT_KEEP_PREC);
+  }
+  catch (...) {
+    _clear();
+    throw;
+  }
+
+  VERIFY(valid());
+}
+
 bool amount_t::valid() const
 {
   if (quantity) {
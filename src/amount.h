@@ -122,6 +122,9 @@ protected:
   void _dup();
   void _clear();
   void _release();
+  bool _parse(const string& quant, const string& symbol,
+              annotation_t& details, bool negative,
+              uint_least16_t comm_flags, const parse_flags_t& flags);
 
   struct bigint_t;
 
@@ -677,15 +680,21 @@ public:
       parse(string, flags_t) parses an amount from the given string.
 
       parse(string, flags_t) also parses an amount from a string.
+
+      parse(const char *, size_t, size_t&, flags_t) parses an amount
+      from the start of the given characters, without the cost of a
+      stream, and sets its third argument to the number of characters
+      used.
   */
   bool parse(std::istream& in,
              const parse_flags_t& flags = PARSE_DEFAULT);
   bool parse(const string& str,
              const parse_flags_t& flags = PARSE_DEFAULT) {
-    std::istringstream stream(str);
-    bool result = parse(stream, flags);
-    return result;
+    std::size_t consumed;
+    return parse(str.c_str(), str.length(), consumed, flags);
   }
+  bool parse(const char * str, std::size_t len, std::size_t& consumed,
+             const parse_flags_t& flags = PARSE_DEFAULT);
 
   static void parse_conversion(const string& larger_str,
                                const string& smaller_str);
@@ -720,6 +729,25 @@ public:
 
   /*@}*/
 
+  /** @name Serialization
+   */
+  /*@{*/
+
+  /** The quantity of an amount, along with its internal precision, may be
+      written in a compact binary form and read back again exactly, which is
+      how the journal cache (see archive.h) stores amounts.  The commodity is
+      not part of this form; the caller must record it separately and restore
+      it using set_commodity().
+
+      read_quantity(data, end) reads a quantity from the buffer at `data',
+      advancing it past what was read.  An amount_error is thrown if the
+      quantity would extend beyond `end'.
+  */
+  void write_quantity(std::ostream& out) const;
+  void read_quantity(const char *& data, const char * end);
+
+  /*@}*/
+
   /** @name Debugging
    */
   /*@{*/
@@ -0,0 +1,1226 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <system.hh>
+
+#include "archive.h"
+#include "amount.h"
+#include "balance.h"
+#include "commodity.h"
+#include "annotate.h"
+#include "pool.h"
+#include "account.h"
+#include "xact.h"
+#include "post.h"
+#include "query.h"
+
+#define ARCHIVE_VERSION 0x00000002
+#define ARCHIVE_MAGIC   0x4c444743      // "LDGC"
+#define ARCHIVE_BOM     0x01020304      // detects a change of byte order
+
+namespace ledger {
+
+namespace {
+  const uint32_t no_index = static_cast<uint32_t>(-1);
+
+  const datetime_t unix_epoch(date_t(1970, 1, 1));
+
+  // A Fowler-Noll-Vo hash of the archive's contents, so that a truncated
+  // or damaged archive is not mistaken for a good one.
+  uint64_t checksum(const char * data, std::size_t size)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char * p = data; p < data + size; p++) {
+      hash ^= static_cast<unsigned char>(*p);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  class writer_t
+  {
+    std::ostream& out;
+
+    std::map<string, uint32_t>                       path_ids;
+    std::map<const commodity_t *, uint32_t>          commodity_ids;
+    std::map<const account_t *, uint32_t>            account_ids;
+    std::unordered_map<const post_t *, uint32_t>     post_ids;
+    std::unordered_map<const xact_t *, uint32_t>     xact_ids;
+    std::vector<const account_t *>                   accounts;
+
+  public:
+    writer_t(std::ostream& _out) : out(_out) {}
+
+    template <typename T>
+    void write_number(const T num) {
+      out.write(reinterpret_cast<const char *>(&num), sizeof(T));
+    }
+    void write_bool(const bool truth) {
+      write_number<uint8_t>(truth ? 1 : 0);
+    }
+    void write_string(const string& str) {
+      write_number<uint32_t>(static_cast<uint32_t>(str.length()));
+      out.write(str.data(), static_cast<std::streamsize>(str.length()));
+    }
+    void write_string(const optional<string>& str) {
+      write_bool(static_cast<bool>(str));
+      if (str)
+        write_string(*str);
+    }
+
+    void write_path(const path& pathname);
+    void write_datetime(const datetime_t& when);
+    void write_datetime(const optional<datetime_t>& when) {
+      write_bool(static_cast<bool>(when));
+      if (when)
+        write_datetime(*when);
+    }
+    void write_date(const date_t& when);
+    void write_date(const optional<date_t>& when) {
+      write_bool(static_cast<bool>(when));
+      if (when)
+        write_date(*when);
+    }
+
+    void write_commodity(const commodity_t * comm);
+    void write_amount(const amount_t& amt);
+    void write_amount(const optional<amount_t>& amt) {
+      write_bool(static_cast<bool>(amt));
+      if (amt)
+        write_amount(*amt);
+    }
+    void write_expr(const expr_t& expr);
+    void write_expr(const optional<expr_t>& expr) {
+      write_bool(static_cast<bool>(expr));
+      if (expr)
+        write_expr(*expr);
+    }
+    void write_value(const value_t& value);
+    void write_account(const account_t * acct);
+    void write_annotation(const annotation_t& details);
+
+    void write_item(const item_t& item);
+    void write_post(const post_t& post);
+    void write_posts(const xact_base_t& xact);
+
+    void write_commodities(commodity_pool_t& pool);
+    void collect_accounts(const account_t * acct);
+    void write_journal(journal_t& journal);
+  };
+
+  void writer_t::write_path(const path& pathname)
+  {
+    // Every item records the file it came from, so each path is written
+    // out in full only the first time it is seen.
+    std::pair<std::map<string, uint32_t>::iterator, bool> result =
+      path_ids.insert(std::make_pair(pathname.string(),
+                                     static_cast<uint32_t>(path_ids.size())));
+    write_number<uint32_t>((*result.first).second);
+    if (result.second)
+      write_string(pathname.string());
+  }
+
+  void writer_t::write_datetime(const datetime_t& when)
+  {
+    if (when.is_not_a_date_time()) {
+      write_bool(false);
+    } else {
+      if (when.is_special())
+        throw_(archive_error, _("Cannot archive a special date/time"));
+      write_bool(true);
+      write_number<int64_t>((when - unix_epoch).ticks());
+    }
+  }
+
+  void writer_t::write_date(const date_t& when)
+  {
+    if (when.is_special())
+      throw_(archive_error, _("Cannot archive a special date"));
+    write_number<uint32_t>(when.day_number());
+  }
+
+  void writer_t::write_commodity(const commodity_t * comm)
+  {
+    if (! comm) {
+      write_number<uint32_t>(no_index);
+    } else {
+      std::map<const commodity_t *, uint32_t>::const_iterator
+        i = commodity_ids.find(comm);
+      if (i == commodity_ids.end())
+        throw_(archive_error,
+               _f("Cannot archive unknown commodity '%1%'") % comm->symbol());
+      write_number<uint32_t>((*i).second);
+    }
+  }
+
+  void writer_t::write_amount(const amount_t& amt)
+  {
+    write_commodity(amt.has_commodity() ? &amt.commodity() : NULL);
+    amt.write_quantity(out);
+  }
+
+  void writer_t::write_expr(const expr_t& expr)
+  {
+    // Expressions are archived as their source text, and compiled again
+    // when the archive is loaded.
+    string text(expr.text());
+    if ((text.empty() && expr) || text == "<stream>")
+      throw_(archive_error, _("Cannot archive an expression without text"));
+    write_string(text);
+  }
+
+  void writer_t::write_value(const value_t& value)
+  {
+    write_number<uint8_t>(static_cast<uint8_t>(value.type()));
+
+    switch (value.type()) {
+    case value_t::VOID:
+      break;
+    case value_t::BOOLEAN:
+      write_bool(value.as_boolean());
+      break;
+    case value_t::DATETIME:
+      write_datetime(value.as_datetime());
+      break;
+    case value_t::DATE:
+      write_date(value.as_date());
+      break;
+    case value_t::INTEGER:
+      write_number<int64_t>(value.as_long());
+      break;
+    case value_t::AMOUNT:
+      write_amount(value.as_amount());
+      break;
+    case value_t::BALANCE:
+      write_number<uint32_t>
+        (static_cast<uint32_t>(value.as_balance().amounts.size()));
+      foreach (const balance_t::amounts_map::value_type& pair,
+               value.as_balance().amounts)
+        write_amount(pair.second);
+      break;
+    case value_t::STRING:
+      write_string(value.as_string());
+      break;
+    case value_t::MASK:
+      write_string(value.as_mask().str());
+      break;
+    case value_t::SEQUENCE:
+      write_number<uint32_t>
+        (static_cast<uint32_t>(value.as_sequence().size()));
+      foreach (const value_t& member, value.as_sequence())
+        write_value(member);
+      break;
+    case value_t::SCOPE:
+    case value_t::ANY:
+      throw_(archive_error,
+             _f("Cannot archive a value of type %1%") % value.label());
+    }
+  }
+
+  void writer_t::write_account(const account_t * acct)
+  {
+    if (! acct) {
+      write_number<uint32_t>(no_index);
+    } else {
+      std::map<const account_t *, uint32_t>::const_iterator
+        i = account_ids.find(acct);
+      if (i == account_ids.end())
+        throw_(archive_error,
+               _f("Cannot archive unknown account '%1%'") % acct->fullname());
+      write_number<uint32_t>((*i).second);
+    }
+  }
+
+  void writer_t::write_annotation(const annotation_t& details)
+  {
+    write_number<uint8_t>(details.flags());
+    write_amount(details.price);
+    write_date(details.date);
+    write_string(details.tag);
+    write_expr(details.value_expr);
+  }
+
+  void writer_t::write_item(const item_t& item)
+  {
+    write_number<uint16_t>(item.flags());
+    write_number<uint8_t>(static_cast<uint8_t>(item._state));
+    write_date(item._date);
+    write_date(item._date_aux);
+    write_string(item.note);
+
+    write_bool(static_cast<bool>(item.pos));
+    if (item.pos) {
+      write_path(item.pos->pathname);
+      write_number<int64_t>(static_cast<std::streamoff>(item.pos->beg_pos));
+      write_number<uint64_t>(item.pos->beg_line);
+      write_number<int64_t>(static_cast<std::streamoff>(item.pos->end_pos));
+      write_number<uint64_t>(item.pos->end_line);
+      write_number<uint64_t>(item.pos->sequence);
+    }
+
+    write_bool(static_cast<bool>(item.metadata));
+    if (item.metadata) {
+      write_number<uint32_t>(static_cast<uint32_t>(item.metadata->size()));
+      foreach (const tag_map_t::value_type& data, *item.metadata) {
+        write_string(data.first);
+        write_bool(static_cast<bool>(data.second.first));
+        if (data.second.first)
+          write_value(*data.second.first);
+        write_bool(data.second.second);
+      }
+    }
+  }
+
+  void writer_t::write_post(const post_t& post)
+  {
+    write_item(post);
+    write_account(post.account);
+    write_amount(post.amount);
+    write_expr(post.amount_expr);
+    write_amount(post.cost);
+    write_amount(post.given_cost);
+    write_amount(post.assigned_amount);
+    write_datetime(post.checkin);
+    write_datetime(post.checkout);
+  }
+
+  void writer_t::write_posts(const xact_base_t& xact)
+  {
+    write_number<uint32_t>(static_cast<uint32_t>(xact.posts.size()));
+    foreach (const post_t * post, xact.posts) {
+      uint32_t id = static_cast<uint32_t>(post_ids.size());
+      post_ids.insert(std::make_pair(post, id));
+      write_post(*post);
+    }
+  }
+
+  void writer_t::write_commodities(commodity_pool_t& pool)
+  {
+    // Base commodities are written in the order they were created, so that
+    // their vertices in the price graph are created in the same order.
+    std::vector<const commodity_t *> bases;
+    foreach (const commodity_pool_t::commodities_map::value_type& pair,
+             pool.commodities)
+      if (pair.first == pair.second->base_symbol())
+        bases.push_back(pair.second.get());
+
+    std::stable_sort(bases.begin(), bases.end(),
+                     [](const commodity_t * left, const commodity_t * right) {
+                       return left->graph_index() < right->graph_index();
+                     });
+
+    write_number<uint32_t>(static_cast<uint32_t>(bases.size()));
+    foreach (const commodity_t * comm, bases) {
+      uint32_t id = static_cast<uint32_t>(commodity_ids.size());
+      commodity_ids.insert(std::make_pair(comm, id));
+      write_string(comm->base_symbol());
+    }
+
+    uint32_t aliases = 0;
+    foreach (const commodity_pool_t::commodities_map::value_type& pair,
+             pool.commodities)
+      if (pair.first != pair.second->base_symbol())
+        aliases++;
+
+    write_number<uint32_t>(aliases);
+    foreach (const commodity_pool_t::commodities_map::value_type& pair,
+             pool.commodities) {
+      if (pair.first != pair.second->base_symbol()) {
+        write_string(pair.first);
+        write_commodity(pair.second.get());
+      }
+    }
+
+    write_number<uint32_t>
+      (static_cast<uint32_t>(pool.annotated_commodities.size()));
+    foreach (const commodity_pool_t::annotated_commodities_map::value_type&
+             pair, pool.annotated_commodities) {
+      write_commodity(&pair.second->referent());
+      write_annotation(pair.second->details);
+
+      uint32_t id = static_cast<uint32_t>(commodity_ids.size());
+      commodity_ids.insert(std::make_pair(pair.second.get(), id));
+    }
+
+    // The details of each commodity come last, since they may refer to
+    // other commodities.
+    foreach (const commodity_t * comm, bases) {
+      write_number<uint16_t>(comm->flags());
+      write_number<uint16_t>(comm->precision());
+      write_string(comm->name());
+      write_string(comm->note());
+      write_amount(comm->smaller());
+      write_amount(comm->larger());
+      write_expr(comm->value_expr());
+    }
+
+    write_commodity(pool.default_commodity);
+
+    typedef tuple<const commodity_t *, datetime_t, amount_t> price_entry_t;
+    std::vector<price_entry_t> prices;
+    pool.commodity_price_history.map_all_prices
+      ([&prices](const commodity_t& source, const datetime_t& when,
+                 const amount_t& price) {
+        prices.push_back(price_entry_t(&source, when, price));
+      });
+
+    write_number<uint32_t>(static_cast<uint32_t>(prices.size()));
+    foreach (const price_entry_t& entry, prices) {
+      write_commodity(entry.get<0>());
+      write_datetime(entry.get<1>());
+      write_amount(entry.get<2>());
+    }
+  }
+
+  void writer_t::collect_accounts(const account_t * acct)
+  {
+    if (acct->deferred_posts && ! acct->deferred_posts->empty())
+      throw_(archive_error, _("Cannot archive deferred postings"));
+
+    uint32_t id = static_cast<uint32_t>(accounts.size());
+    account_ids.insert(std::make_pair(acct, id));
+    accounts.push_back(acct);
+
+    foreach (const accounts_map::value_type& pair, acct->accounts)
+      collect_accounts(pair.second);
+  }
+
+  void writer_t::write_journal(journal_t& journal)
+  {
+    write_commodities(*commodity_pool_t::current_pool);
+
+    // The account tree is written depth-first, so that every account is
+    // preceded by its parent.
+    collect_accounts(journal.master);
+
+    write_number<uint32_t>(static_cast<uint32_t>(accounts.size()));
+    foreach (const account_t * acct, accounts) {
+      write_account(acct->parent);
+      write_string(acct->name);
+      write_string(acct->note);
+      write_number<uint8_t>(acct->flags());
+      write_expr(acct->value_expr);
+    }
+
+    write_account(journal.bucket);
+    write_bool(journal.fixed_accounts);
+    write_bool(journal.fixed_payees);
+    write_bool(journal.fixed_commodities);
+    write_bool(journal.fixed_metadata);
+
+    write_number<uint32_t>(static_cast<uint32_t>(journal.known_payees.size()));
+    foreach (const string& payee, journal.known_payees)
+      write_string(payee);
+    write_number<uint32_t>(static_cast<uint32_t>(journal.known_tags.size()));
+    foreach (const string& tag, journal.known_tags)
+      write_string(tag);
+
+    write_number<uint32_t>
+      (static_cast<uint32_t>(journal.payee_alias_mappings.size()));
+    foreach (const payee_alias_mapping_t& mapping,
+             journal.payee_alias_mappings) {
+      write_string(mapping.first.str());
+      write_string(mapping.second);
+    }
+    write_number<uint32_t>
+      (static_cast<uint32_t>(journal.payee_uuid_mappings.size()));
+    foreach (const payee_uuid_mapping_t& mapping,
+             journal.payee_uuid_mappings) {
+      write_string(mapping.first);
+      write_string(mapping.second);
+    }
+    write_number<uint32_t>
+      (static_cast<uint32_t>(journal.account_mappings.size()));
+    foreach (const account_mapping_t& mapping, journal.account_mappings) {
+      write_string(mapping.first.str());
+      write_account(mapping.second);
+    }
+    write_number<uint32_t>
+      (static_cast<uint32_t>(journal.account_aliases.size()));
+    foreach (const accounts_map::value_type& pair, journal.account_aliases) {
+      write_string(pair.first);
+      write_account(pair.second);
+    }
+    write_number<uint32_t>
+      (static_cast<uint32_t>(journal.payees_for_unknown_accounts.size()));
+    foreach (const account_mapping_t& mapping,
+             journal.payees_for_unknown_accounts) {
+      write_string(mapping.first.str());
+      write_account(mapping.second);
+    }
+    write_number<uint32_t>
+      (static_cast<uint32_t>(journal.tag_check_exprs.size()));
+    foreach (const tag_check_exprs_map::value_type& pair,
+             journal.tag_check_exprs) {
+      write_string(pair.first);
+      write_expr(pair.second.first);
+      write_number<uint8_t>(static_cast<uint8_t>(pair.second.second));
+    }
+    write_expr(journal.value_expr);
+
+    write_number<uint32_t>(static_cast<uint32_t>(journal.xacts.size()));
+    foreach (const xact_t * xact, journal.xacts) {
+      uint32_t id = static_cast<uint32_t>(xact_ids.size());
+      xact_ids.insert(std::make_pair(xact, id));
+
+      write_item(*xact);
+      write_string(xact->code);
+      write_string(xact->payee);
+      write_posts(*xact);
+    }
+
+    write_number<uint32_t>(static_cast<uint32_t>(journal.auto_xacts.size()));
+    foreach (const auto_xact_t * xact, journal.auto_xacts) {
+      write_item(*xact);
+
+      // The predicate's text is the query it was parsed from.
+      if (xact->predicate.text().empty())
+        throw_(archive_error,
+               _("Cannot archive an automated transaction without a query"));
+      write_string(xact->predicate.text());
+      write_bool(xact->predicate.what_to_keep.keep_price);
+      write_bool(xact->predicate.what_to_keep.keep_date);
+      write_bool(xact->predicate.what_to_keep.keep_tag);
+      write_bool(xact->predicate.what_to_keep.only_actuals);
+      write_bool(xact->try_quick_match);
+
+      write_bool(static_cast<bool>(xact->check_exprs));
+      if (xact->check_exprs) {
+        write_number<uint32_t>
+          (static_cast<uint32_t>(xact->check_exprs->size()));
+        foreach (const expr_t::check_expr_pair& pair, *xact->check_exprs) {
+          write_expr(pair.first);
+          write_number<uint8_t>(static_cast<uint8_t>(pair.second));
+        }
+      }
+
+      write_posts(*xact);
+
+      write_bool(static_cast<bool>(xact->deferred_notes));
+      if (xact->deferred_notes) {
+        write_number<uint32_t>
+          (static_cast<uint32_t>(xact->deferred_notes->size()));
+        foreach (const auto_xact_t::deferred_tag_data_t& data,
+                 *xact->deferred_notes) {
+          write_string(data.tag_data);
+          write_bool(data.overwrite_existing);
+
+          uint32_t index = no_index, i = 0;
+          foreach (const post_t * post, xact->posts) {
+            if (post == data.apply_to_post)
+              index = i;
+            i++;
+          }
+          write_number<uint32_t>(index);
+        }
+      }
+    }
+
+    write_number<uint32_t>(static_cast<uint32_t>(journal.period_xacts.size()));
+    foreach (const period_xact_t * xact, journal.period_xacts) {
+      write_item(*xact);
+      write_string(xact->period_string);
+      write_posts(*xact);
+    }
+
+    write_number<uint32_t>(static_cast<uint32_t>(journal.checksum_map.size()));
+    foreach (const checksum_map_t::value_type& pair, journal.checksum_map) {
+      std::unordered_map<const xact_t *, uint32_t>::const_iterator
+        i = xact_ids.find(pair.second);
+      if (i == xact_ids.end())
+        throw_(archive_error, _("Cannot archive an unknown transaction"));
+      write_string(pair.first);
+      write_number<uint32_t>((*i).second);
+    }
+
+    // Lastly, the postings of each account, in the order they were added
+    // to it.
+    foreach (const account_t * acct, accounts) {
+      write_number<uint32_t>(static_cast<uint32_t>(acct->posts.size()));
+      foreach (const post_t * post, acct->posts) {
+        std::unordered_map<const post_t *, uint32_t>::const_iterator
+          i = post_ids.find(post);
+        if (i == post_ids.end())
+          throw_(archive_error, _("Cannot archive an unknown posting"));
+        write_number<uint32_t>((*i).second);
+      }
+    }
+  }
+
+  class reader_t
+  {
+    const char * data;
+    const char * end;
+
+    std::vector<path>          paths;
+    std::vector<commodity_t *> commodities;
+    std::vector<account_t *>   accounts;
+    std::vector<post_t *>      posts;
+    std::vector<xact_t *>      xacts;
+
+  public:
+    reader_t(const char * _data, std::size_t size)
+      : data(_data), end(_data + size) {}
+
+    const char * position() const {
+      return data;
+    }
+    std::size_t remaining() const {
+      return static_cast<std::size_t>(end - data);
+    }
+
+    void need(std::size_t size) {
+      if (static_cast<std::size_t>(end - data) < size)
+        throw_(archive_error, _("Archive is truncated"));
+    }
+
+    template <typename T>
+    T read_number() {
+      T num;
+      need(sizeof(T));
+      std::memcpy(&num, data, sizeof(T));
+      data += sizeof(T);
+      return num;
+    }
+    bool read_bool() {
+      return read_number<uint8_t>() != 0;
+    }
+    string read_string() {
+      uint32_t len = read_number<uint32_t>();
+      need(len);
+      string str(data, len);
+      data += len;
+      return str;
+    }
+    optional<string> read_optional_string() {
+      if (read_bool())
+        return read_string();
+      return none;
+    }
+
+    path read_path();
+    datetime_t read_datetime();
+    optional<datetime_t> read_optional_datetime() {
+      if (read_bool())
+        return read_datetime();
+      return none;
+    }
+    date_t read_date();
+    optional<date_t> read_optional_date() {
+      if (read_bool())
+        return read_date();
+      return none;
+    }
+
+    commodity_t * read_commodity();
+    amount_t read_amount();
+    optional<amount_t> read_optional_amount() {
+      if (read_bool())
+        return read_amount();
+      return none;
+    }
+    expr_t read_expr();
+    optional<expr_t> read_optional_expr() {
+      if (read_bool())
+        return read_expr();
+      return none;
+    }
+    value_t read_value();
+    account_t * read_account();
+    annotation_t read_annotation();
+
+    void read_item(item_t& item);
+    void read_post(post_t& post);
+    void read_posts(journal_t& journal, xact_base_t& xact);
+
+    void read_commodities(commodity_pool_t& pool);
+    void read_journal(journal_t& journal);
+  };
+
+  path reader_t::read_path()
+  {
+    uint32_t id = read_number<uint32_t>();
+    if (id == paths.size())
+      paths.push_back(path(read_string()));
+    else if (id > paths.size())
+      throw_(archive_error, _("Archive refers to an unknown file"));
+    return paths[id];
+  }
+
+  datetime_t reader_t::read_datetime()
+  {
+    if (! read_bool())
+      return datetime_t();
+    return unix_epoch + time_duration_t(0, 0, 0, read_number<int64_t>());
+  }
+
+  date_t reader_t::read_date()
+  {
+    return date_t(gregorian::gregorian_calendar::from_day_number
+                  (read_number<uint32_t>()));
+  }
+
+  commodity_t * reader_t::read_commodity()
+  {
+    uint32_t id = read_number<uint32_t>();
+    if (id == no_index)
+      return NULL;
+    if (id >= commodities.size())
+      throw_(archive_error, _("Archive refers to an unknown commodity"));
+    return commodities[id];
+  }
+
+  amount_t reader_t::read_amount()
+  {
+    amount_t      amt;
+    commodity_t * comm = read_commodity();
+    amt.read_quantity(data, end);
+    if (comm)
+      amt.set_commodity(*comm);
+    return amt;
+  }
+
+  expr_t reader_t::read_expr()
+  {
+    // The amounts within an expression were seen once already, when the
+    // journal was parsed, so they must not change any display precisions.
+    return expr_t(read_string(), PARSE_NO_MIGRATE);
+  }
+
+  value_t reader_t::read_value()
+  {
+    switch (read_number<uint8_t>()) {
+    case value_t::VOID:
+      return NULL_VALUE;
+    case value_t::BOOLEAN:
+      return value_t(read_bool());
+    case value_t::DATETIME:
+      return value_t(read_datetime());
+    case value_t::DATE:
+      return value_t(read_date());
+    case value_t::INTEGER:
+      return value_t(static_cast<long>(read_number<int64_t>()));
+    case value_t::AMOUNT:
+      return value_t(read_amount());
+    case value_t::BALANCE: {
+      balance_t bal;
+      for (uint32_t count = read_number<uint32_t>(); count > 0; count--)
+        bal += read_amount();
+      return value_t(bal);
+    }
+    case value_t::STRING:
+      return string_value(read_string());
+    case value_t::MASK:
+      return mask_value(read_string());
+    case value_t::SEQUENCE: {
+      value_t::sequence_t seq;
+      for (uint32_t count = read_number<uint32_t>(); count > 0; count--)
+        seq.push_back(new value_t(read_value()));
+      return value_t(seq);
+    }
+    default:
+      throw_(archive_error, _("Archive contains a value of unknown type"));
+    }
+    return NULL_VALUE;
+  }
+
+  account_t * reader_t::read_account()
+  {
+    uint32_t id = read_number<uint32_t>();
+    if (id == no_index)
+      return NULL;
+    if (id >= accounts.size())
+      throw_(archive_error, _("Archive refers to an unknown account"));
+    return accounts[id];
+  }
+
+  annotation_t reader_t::read_annotation()
+  {
+    uint8_t flags = read_number<uint8_t>();
+
+    annotation_t details;
+    details.price      = read_optional_amount();
+    details.date       = read_optional_date();
+    details.tag        = read_optional_string();
+    details.value_expr = read_optional_expr();
+    details.set_flags(flags);
+    return details;
+  }
+
+  void reader_t::read_item(item_t& item)
+  {
+    item.set_flags(read_number<uint16_t>());
+    item.set_state(static_cast<item_t::state_t>(read_number<uint8_t>()));
+    item._date     = read_optional_date();
+    item._date_aux = read_optional_date();
+    item.note      = read_optional_string();
+
+    if (read_bool()) {
+      item.pos = position_t();
+      item.pos->pathname = read_path();
+      item.pos->beg_pos  = static_cast<std::streamoff>(read_number<int64_t>());
+      item.pos->beg_line = read_number<uint64_t>();
+      item.pos->end_pos  = static_cast<std::streamoff>(read_number<int64_t>());
+      item.pos->end_line = read_number<uint64_t>();
+      item.pos->sequence = read_number<uint64_t>();
+    }
+
+    if (read_bool()) {
+      for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+        string            tag(read_string());
+        optional<value_t> value;
+        if (read_bool())
+          value = read_value();
+        bool inherited = read_bool();
+
+        (*item.set_tag(tag)).second = item_t::tag_data_t(value, inherited);
+      }
+    }
+  }
+
+  void reader_t::read_post(post_t& post)
+  {
+    read_item(post);
+    post.account         = read_account();
+    post.amount          = read_amount();
+    post.amount_expr     = read_optional_expr();
+    post.cost            = read_optional_amount();
+    post.given_cost      = read_optional_amount();
+    post.assigned_amount = read_optional_amount();
+    post.checkin         = read_optional_datetime();
+    post.checkout        = read_optional_datetime();
+  }
+
+  void reader_t::read_posts(journal_t& journal, xact_base_t& xact)
+  {
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      unique_ptr<post_t> post(new (journal.arena) post_t);
+      read_post(*post);
+      xact.add_post(post.get());
+      posts.push_back(post.release());
+    }
+  }
+
+  void reader_t::read_commodities(commodity_pool_t& pool)
+  {
+    uint32_t bases = read_number<uint32_t>();
+    for (uint32_t count = bases; count > 0; count--)
+      commodities.push_back(pool.find_or_create(read_string()));
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      string        name(read_string());
+      commodity_t * comm = read_commodity();
+      if (! comm)
+        throw_(archive_error, _("Archive contains an invalid alias"));
+      if (! pool.find(name))
+        pool.alias(name, *comm);
+    }
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      commodity_t * comm = read_commodity();
+      if (! comm || comm->has_annotation())
+        throw_(archive_error,
+               _("Archive contains an invalid annotated commodity"));
+      annotation_t details(read_annotation());
+      commodities.push_back(pool.find_or_create(*comm, details));
+    }
+
+    for (uint32_t i = 0; i < bases; i++) {
+      commodity_t * comm = commodities[i];
+      comm->set_flags(read_number<uint16_t>());
+      comm->set_precision(read_number<uint16_t>());
+      comm->set_name(read_optional_string());
+      comm->set_note(read_optional_string());
+      comm->set_smaller(read_optional_amount());
+      comm->set_larger(read_optional_amount());
+      comm->set_value_expr(read_optional_expr());
+    }
+
+    pool.default_commodity = read_commodity();
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      commodity_t * source = read_commodity();
+      datetime_t    when   = read_datetime();
+      amount_t      price  = read_amount();
+      if (! source || ! price.has_commodity() ||
+          source->graph_index() == price.commodity().graph_index())
+        throw_(archive_error, _("Archive contains an invalid price"));
+      pool.commodity_price_history.add_price(*source, when, price);
+    }
+  }
+
+  void reader_t::read_journal(journal_t& journal)
+  {
+    read_commodities(*commodity_pool_t::current_pool);
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      account_t * parent = read_account();
+      string      name(read_string());
+      account_t * acct;
+      if (! parent) {
+        if (! accounts.empty())
+          throw_(archive_error, _("Archive contains an invalid account"));
+        acct = journal.master;
+      } else {
+        acct = parent->find_account(name);
+      }
+      acct->note = read_optional_string();
+      acct->set_flags(read_number<uint8_t>());
+      acct->value_expr = read_optional_expr();
+      accounts.push_back(acct);
+    }
+
+    journal.bucket            = read_account();
+    journal.fixed_accounts    = read_bool();
+    journal.fixed_payees      = read_bool();
+    journal.fixed_commodities = read_bool();
+    journal.fixed_metadata    = read_bool();
+
+    // The collections below replace any that were built while reading the
+    // initialization file, since the archive already includes those.
+    journal.known_payees.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--)
+      journal.known_payees.insert(read_string());
+    journal.known_tags.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--)
+      journal.known_tags.insert(read_string());
+
+    journal.payee_alias_mappings.clear();
+    journal.payee_alias_index.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      mask_t mask(read_string());
+      journal.payee_alias_mappings.push_back
+        (payee_alias_mapping_t(mask, read_string()));
+    }
+    journal.payee_uuid_mappings.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      string payee(read_string());
+      journal.payee_uuid_mappings.push_back
+        (payee_uuid_mapping_t(payee, read_string()));
+    }
+    journal.account_mappings.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      mask_t mask(read_string());
+      journal.account_mappings.push_back
+        (account_mapping_t(mask, read_account()));
+    }
+    journal.account_aliases.clear();
+    journal.alias_index.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      string name(read_string());
+      journal.account_aliases[name] = read_account();
+    }
+    journal.payees_for_unknown_accounts.clear();
+    journal.unknown_account_index.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      mask_t mask(read_string());
+      journal.payees_for_unknown_accounts.push_back
+        (account_mapping_t(mask, read_account()));
+    }
+    journal.tag_check_exprs.clear();
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      string tag(read_string());
+      expr_t expr(read_expr());
+      journal.tag_check_exprs.insert
+        (tag_check_exprs_map::value_type
+         (tag, expr_t::check_expr_pair
+          (expr, static_cast<expr_t::check_expr_kind_t>
+           (read_number<uint8_t>()))));
+    }
+    journal.value_expr = read_optional_expr();
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      unique_ptr<xact_t> xact(new (journal.arena) xact_t);
+      read_item(*xact);
+      xact->code  = read_optional_string();
+      xact->payee = read_string();
+      read_posts(journal, *xact);
+
+      xact->journal = &journal;
+      journal.xacts.push_back(xact.get());
+      xacts.push_back(xact.release());
+    }
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      unique_ptr<auto_xact_t> xact(new auto_xact_t);
+      read_item(*xact);
+
+      string         query_text(read_string());
+      keep_details_t keeper;
+      keeper.keep_price   = read_bool();
+      keeper.keep_date    = read_bool();
+      keeper.keep_tag     = read_bool();
+      keeper.only_actuals = read_bool();
+
+      query_t query;
+      xact->predicate = predicate_t
+        (query.parse_args(string_value(query_text).to_sequence(),
+                          keeper, false, true), keeper);
+      xact->predicate.set_text(query_text);
+      xact->try_quick_match = read_bool();
+
+      if (read_bool()) {
+        xact->check_exprs = expr_t::check_expr_list();
+        for (uint32_t checks = read_number<uint32_t>(); checks > 0; checks--) {
+          expr_t expr(read_expr());
+          xact->check_exprs->push_back
+            (expr_t::check_expr_pair
+             (expr, static_cast<expr_t::check_expr_kind_t>
+              (read_number<uint8_t>())));
+        }
+      }
+
+      read_posts(journal, *xact);
+
+      if (read_bool()) {
+        xact->deferred_notes = auto_xact_t::deferred_notes_list();
+        for (uint32_t notes = read_number<uint32_t>(); notes > 0; notes--) {
+          string tag_data(read_string());
+          bool   overwrite_existing = read_bool();
+          auto_xact_t::deferred_tag_data_t
+            data(tag_data, overwrite_existing);
+
+          uint32_t index = read_number<uint32_t>();
+          if (index != no_index) {
+            if (index >= xact->posts.size())
+              throw_(archive_error, _("Archive contains an invalid note"));
+            data.apply_to_post = *std::next(xact->posts.begin(), index);
+          }
+          xact->deferred_notes->push_back(data);
+        }
+      }
+
+      xact->journal = &journal;
+      journal.auto_xacts.push_back(xact.release());
+    }
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      unique_ptr<period_xact_t> xact(new period_xact_t);
+      read_item(*xact);
+      xact->period_string = read_string();
+      xact->period        = date_interval_t(xact->period_string);
+      read_posts(journal, *xact);
+
+      xact->journal = &journal;
+      journal.period_xacts.push_back(xact.release());
+    }
+
+    for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+      string   uuid(read_string());
+      uint32_t id = read_number<uint32_t>();
+      if (id >= xacts.size())
+        throw_(archive_error, _("Archive refers to an unknown transaction"));
+      journal.checksum_map[uuid] = xacts[id];
+    }
+
+    foreach (account_t * acct, accounts) {
+      for (uint32_t count = read_number<uint32_t>(); count > 0; count--) {
+        uint32_t id = read_number<uint32_t>();
+        if (id >= posts.size())
+          throw_(archive_error, _("Archive refers to an unknown posting"));
+        acct->posts.push_back(posts[id]);
+      }
+    }
+
+    if (data != end)
+      throw_(archive_error, _("Archive contains unexpected data"));
+  }
+}
+
+archive_t::archive_t(const path& _file, const string& _key)
+  : file(_file), key(_key), body(NULL), body_size(0)
+{
+  TRACE_CTOR(archive_t, "const path&, const string&");
+}
+
+archive_t::~archive_t()
+{
+  TRACE_DTOR(archive_t);
+}
+
+bool archive_t::should_load()
+{
+  if (! exists(file) || ! is_regular_file(file) || file_size(file) == 0)
+    return false;
+
+  try {
+    mapping.reset(new boost::iostreams::mapped_file_source(file.string()));
+  }
+  catch (const std::exception& err) {
+    DEBUG("archive.journal", "Could not map archive: " << err.what());
+    return false;
+  }
+
+  try {
+    reader_t header(mapping->data(), mapping->size());
+
+    if (header.read_number<uint32_t>() != ARCHIVE_MAGIC ||
+        header.read_number<uint32_t>() != ARCHIVE_VERSION ||
+        header.read_number<uint32_t>() != ARCHIVE_BOM) {
+      DEBUG("archive.journal", "Archive version or byte order has changed");
+      return false;
+    }
+    if (header.read_string() != key) {
+      DEBUG("archive.journal", "Archive was made with different options");
+      return false;
+    }
+
+    sources.clear();
+    for (uint32_t count = header.read_number<uint32_t>(); count > 0; count--) {
+      journal_t::fileinfo_t info;
+      info.filename    = path(header.read_string());
+      info.size        = header.read_number<uint64_t>();
+      info.modtime     = header.read_datetime();
+      info.from_stream = false;
+
+      if (! exists(*info.filename) ||
+          file_size(*info.filename) != info.size ||
+          posix_time::from_time_t(last_write_time(*info.filename)) !=
+          info.modtime) {
+        DEBUG("archive.journal", "Source file " << *info.filename
+              << " has changed since the archive was made");
+        return false;
+      }
+      sources.push_back(info);
+    }
+
+    body_size = header.read_number<uint64_t>();
+    uint64_t sum = header.read_number<uint64_t>();
+    if (header.remaining() != body_size) {
+      DEBUG("archive.journal", "Archive is truncated");
+      return false;
+    }
+    body = header.position();
+
+    if (checksum(body, body_size) != sum) {
+      DEBUG("archive.journal", "Archive is damaged");
+      return false;
+    }
+  }
+  catch (const archive_error& err) {
+    DEBUG("archive.journal", "Could not read archive: " << err.what());
+    return false;
+  }
+  return true;
+}
+
+bool archive_t::should_save(const journal_t& journal) const
+{
+  if (journal.was_loaded || ! journal.cacheable)
+    return false;
+
+  foreach (const journal_t::fileinfo_t& info, journal.sources)
+    if (info.from_stream || ! info.filename)
+      return false;
+
+  return true;
+}
+
+void archive_t::load(journal_t& journal)
+{
+  assert(body);
+
+  INFO("Loading journal from archive " << file);
+
+  reader_t reader(body, body_size);
+  reader.read_journal(journal);
+
+  journal.sources    = sources;
+  journal.was_loaded = true;
+}
+
+void archive_t::save(journal_t& journal)
+{
+  std::ostringstream contents;
+  try {
+    writer_t writer(contents);
+    writer.write_journal(journal);
+  }
+  catch (const archive_error& err) {
+    DEBUG("archive.journal", "Journal cannot be archived: " << err.what());
+    return;
+  }
+
+  INFO("Saving journal to archive " << file);
+
+  string body_data(contents.str());
+
+  std::ostringstream header_data;
+  writer_t header(header_data);
+  header.write_number<uint32_t>(ARCHIVE_MAGIC);
+  header.write_number<uint32_t>(ARCHIVE_VERSION);
+  header.write_number<uint32_t>(ARCHIVE_BOM);
+  header.write_string(key);
+
+  // A file may have been read more than once, for example by being
+  // included from two places, but only needs to be checked once.
+  std::set<path> seen;
+  std::list<const journal_t::fileinfo_t *> files;
+  foreach (const journal_t::fileinfo_t& info, journal.sources)
+    if (seen.insert(*info.filename).second)
+      files.push_back(&info);
+
+  header.write_number<uint32_t>(static_cast<uint32_t>(files.size()));
+  foreach (const journal_t::fileinfo_t * info, files) {
+    header.write_string(info->filename->string());
+    header.write_number<uint64_t>(info->size);
+    header.write_datetime(info->modtime);
+  }
+  header.write_number<uint64_t>(body_data.size());
+  header.write_number<uint64_t>(checksum(body_data.data(), body_data.size()));
+
+  // Write the archive under a temporary name first, so that another
+  // process never sees a partially written archive.  Failing to write it
+  // is not an error, since the journal itself was read successfully.
+  path temp(file.string() + ".tmp");
+  try {
+    temp = filesystem::unique_path(file.string() + ".%%%%-%%%%");
+
+    ofstream out(temp, std::ios::out | std::ios::binary);
+    string   header_str(header_data.str());
+    out.write(header_str.data(),
+              static_cast<std::streamsize>(header_str.size()));
+    out.write(body_data.data(),
+              static_cast<std::streamsize>(body_data.size()));
+    out.close();
+    if (! out)
+      throw_(archive_error, _("Write failed"));
+
+    filesystem::rename(temp, file);
+  }
+  catch (const std::exception& err) {
+    boost::system::error_code ec;
+    filesystem::remove(temp, ec);
+    warning_(_f("Could not write cache file %1%: %2%") % file % err.what());
+  }
+}
+
+} // namespace ledger
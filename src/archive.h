@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup data
+ */
+
+/**
+ * @file   archive.h
+ * @author John Wiegley
+ *
+ * @ingroup data
+ *
+ * @brief  A binary cache of fully parsed journals
+ *
+ * Parsing a large journal is by far the most expensive part of most
+ * reports.  An archive_t holds everything that parsing produced -- the
+ * commodity pool and its price history, the account tree, and every
+ * transaction and posting -- in a file which can be mapped into memory
+ * and turned back into a journal far more quickly than the textual parser
+ * could read the original files.
+ *
+ * An archive records the size and modification time of every file that
+ * went into it, along with a key describing the options in effect when it
+ * was made, and is only used while all of these remain the same.
+ */
+#ifndef _ARCHIVE_H
+#define _ARCHIVE_H
+
+#include "journal.h"
+
+namespace ledger {
+
+DECLARE_EXCEPTION(archive_error, std::runtime_error);
+
+class archive_t : public noncopyable
+{
+  path   file;
+  string key;
+
+  unique_ptr<boost::iostreams::mapped_file_source> mapping;
+
+  const char * body;
+  std::size_t  body_size;
+
+  std::list<journal_t::fileinfo_t> sources;
+
+public:
+  archive_t(const path& _file, const string& _key);
+  ~archive_t();
+
+  // Returns true if the archive exists, is intact, was made using the same
+  // key, and none of the files it was made from have changed since.
+  bool should_load();
+  bool should_save(const journal_t& journal) const;
+
+  void load(journal_t& journal);
+  void save(journal_t& journal);
+};
+
+} // namespace ledger
+
+#endif // _ARCHIVE_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @addtogroup util
+ */
+
+/**
+ * @file   arena.h
+ * @author John Wiegley
+ *
+ * @ingroup util
+ *
+ * @brief Bump allocation for objects which all die together.
+ *
+ * A journal allocates the transactions and postings it parses from an
+ * arena_t, which hands out memory from large chunks and gives it all
+ * back at once when the journal is destroyed.  Objects are still
+ * destructed one by one, but their storage is not freed individually.
+ */
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include "utils.h"
+
+namespace ledger {
+
+class arena_t : public noncopyable
+{
+  std::vector<char *> chunks;
+  char *              next;
+  std::size_t         left;
+  std::size_t         chunk_size;
+
+public:
+  explicit arena_t(std::size_t _chunk_size = 256 * 1024)
+    : next(NULL), left(0), chunk_size(_chunk_size) {
+    TRACE_CTOR(arena_t, "std::size_t");
+  }
+  ~arena_t() {
+    TRACE_DTOR(arena_t);
+    foreach (char * chunk, chunks)
+      ::operator delete(chunk);
+  }
+
+  /**
+   * Returns SIZE bytes aligned to ALIGN, which must be a power of two no
+   * greater than the alignment ::operator new guarantees.  The memory is
+   * only reclaimed when the arena itself is destroyed.
+   */
+  void * allocate(std::size_t size,
+                  std::size_t align = alignof(std::max_align_t)) {
+    std::size_t pad = (align - reinterpret_cast<std::size_t>(next) % align)
+                      % align;
+    if (pad + size > left) {
+      std::size_t len = std::max(size, chunk_size);
+      chunks.push_back(static_cast<char *>(::operator new(len)));
+      next = chunks.back();
+      left = len;
+      pad  = 0;
+    }
+    void * ptr = next + pad;
+    next += pad + size;
+    left -= pad + size;
+    return ptr;
+  }
+};
+
+/**
+ * Classes deriving from arena_object_t may be created either with plain
+ * new, or with new (arena) to place them in an arena_t.  Either way they
+ * are destroyed with delete, which frees heap storage and leaves arena
+ * storage for the arena to reclaim.  Each object is preceded by a header
+ * recording which of the two it came from, padded so that the object is
+ * aligned as ::operator new would align it.
+ */
+class arena_object_t
+{
+  static const std::size_t header_size = alignof(std::max_align_t);
+
+  static_assert(header_size >= sizeof(arena_t *),
+                "the arena_object_t header must hold a pointer");
+
+  static void * mark(void * ptr, arena_t * arena) {
+    *static_cast<arena_t **>(ptr) = arena;
+    return static_cast<char *>(ptr) + header_size;
+  }
+
+public:
+  static void * operator new(std::size_t size) {
+    return mark(::operator new(size + header_size), NULL);
+  }
+  static void * operator new(std::size_t size, arena_t& arena) {
+    return mark(arena.allocate(size + header_size), &arena);
+  }
+
+  static void operator delete(void * ptr) {
+    if (! ptr)
+      return;
+    char * base = static_cast<char *>(ptr) - header_size;
+    if (! *reinterpret_cast<arena_t **>(base))
+      ::operator delete(base);
+  }
+  static void operator delete(void * ptr, arena_t&) {
+    // Only called when a constructor throws; the storage stays with the
+    // arena.
+    (void)ptr;
+  }
+};
+
+} // namespace ledger
+
+#endif // _ARENA_H
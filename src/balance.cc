@@ -76,11 +76,12 @@ balance_t& balance_t::operator+=(const amount_t& amt)
   if (amt.is_realzero())
     return *this;
 
-  amounts_map::iterator i = amounts.find(&amt.commodity());
-  if (i != amounts.end())
+  commodity_t * comm = &amt.commodity();
+  amounts_map::iterator i = amounts.lower_bound(comm);
+  if (i != amounts.end() && i->first == comm)
     i->second += amt;
   else
-    amounts.insert(amounts_map::value_type(&amt.commodity(), amt));
+    amounts.insert(i, amounts_map::value_type(comm, amt));
 
   return *this;
 }
@@ -101,13 +102,14 @@ balance_t& balance_t::operator-=(const amount_t& amt)
   if (amt.is_realzero())
     return *this;
 
-  amounts_map::iterator i = amounts.find(&amt.commodity());
-  if (i != amounts.end()) {
+  commodity_t * comm = &amt.commodity();
+  amounts_map::iterator i = amounts.lower_bound(comm);
+  if (i != amounts.end() && i->first == comm) {
     i->second -= amt;
     if (i->second.is_realzero())
       amounts.erase(i);
   } else {
-    amounts.insert(amounts_map::value_type(&amt.commodity(), amt.negated()));
+    amounts.insert(i, amounts_map::value_type(comm, amt.negated()));
   }
   return *this;
 }
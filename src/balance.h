@@ -80,7 +80,186 @@ class balance_t
            multiplicative<balance_t, long> > > > > > > > > > > > > >
 {
 public:
-  typedef std::map<commodity_t *, amount_t> amounts_map;
+  /**
+   * A balance rarely holds more than a handful of commodities, so the
+   * first several amounts are kept in a vector sorted by commodity
+   * pointer, the first few of them inside the balance itself, rather than
+   * in a std::map with a separately allocated node for each.  Balances
+   * of lots, which have a commodity for every price paid, can grow to
+   * thousands of amounts; past `small_limit' they move to a std::map, so
+   * that inserting stays logarithmic.  Either way iteration visits the
+   * amounts in the order a std::map keyed by commodity would.
+   *
+   * The interface is the subset of std::map's that balances need.
+   */
+  class amounts_map
+  {
+  public:
+    typedef std::pair<commodity_t *, amount_t> value_type;
+    typedef std::size_t                        size_type;
+
+  private:
+    enum { inline_count = 4, small_limit = 16 };
+
+    typedef boost::container::small_vector<value_type, inline_count>
+      small_type;
+    typedef std::map<commodity_t *, value_type> large_type;
+
+    small_type             small;
+    unique_ptr<large_type> large;
+
+    template <typename Value, typename SmallIter, typename LargeIter>
+    class iterator_t
+      : public boost::iterator_facade<iterator_t<Value, SmallIter, LargeIter>,
+                                      Value, boost::bidirectional_traversal_tag>
+    {
+      friend class boost::iterator_core_access;
+      friend class amounts_map;
+      template <typename, typename, typename> friend class iterator_t;
+
+      SmallIter in_small;
+      LargeIter in_large;
+      bool      is_large;
+
+    public:
+      iterator_t() : in_small(), in_large(), is_large(false) {}
+      iterator_t(SmallIter i) : in_small(i), in_large(), is_large(false) {}
+      iterator_t(LargeIter i) : in_small(), in_large(i), is_large(true) {}
+
+      template <typename OtherValue, typename OtherSmall, typename OtherLarge>
+      iterator_t(const iterator_t<OtherValue, OtherSmall, OtherLarge>& other)
+        : in_small(other.in_small), in_large(other.in_large),
+          is_large(other.is_large) {}
+
+    private:
+      Value& dereference() const {
+        return is_large ? in_large->second : *in_small;
+      }
+
+      template <typename OtherValue, typename OtherSmall, typename OtherLarge>
+      bool equal(const iterator_t<OtherValue, OtherSmall, OtherLarge>& other)
+        const {
+        return is_large ? in_large == other.in_large
+                        : in_small == other.in_small;
+      }
+
+      void increment() {
+        if (is_large) ++in_large; else ++in_small;
+      }
+      void decrement() {
+        if (is_large) --in_large; else --in_small;
+      }
+    };
+
+    void make_large() {
+      large.reset(new large_type);
+      foreach (value_type& entry, small)
+        large->insert(large->end(), large_type::value_type(entry.first,
+                                                           entry));
+      small.clear();
+    }
+
+  public:
+    typedef iterator_t<value_type, small_type::iterator,
+                       large_type::iterator>             iterator;
+    typedef iterator_t<const value_type, small_type::const_iterator,
+                       large_type::const_iterator>       const_iterator;
+
+    amounts_map() {}
+    amounts_map(const amounts_map& other)
+      : small(other.small),
+        large(other.large ? new large_type(*other.large) : NULL) {}
+
+    amounts_map& operator=(const amounts_map& other) {
+      if (this != &other) {
+        small = other.small;
+        large.reset(other.large ? new large_type(*other.large) : NULL);
+      }
+      return *this;
+    }
+
+    iterator begin() {
+      return large ? iterator(large->begin()) : iterator(small.begin());
+    }
+    const_iterator begin() const {
+      return large ? const_iterator(large_type::const_iterator(large->begin()))
+                   : const_iterator(small.begin());
+    }
+    iterator end() {
+      return large ? iterator(large->end()) : iterator(small.end());
+    }
+    const_iterator end() const {
+      return large ? const_iterator(large_type::const_iterator(large->end()))
+                   : const_iterator(small.end());
+    }
+
+    size_type size() const {
+      return large ? large->size() : small.size();
+    }
+    bool empty() const {
+      return large ? large->empty() : small.empty();
+    }
+    void clear() {
+      small.clear();
+      large.reset();
+    }
+
+    // With so few amounts in the vector, a linear search beats a binary
+    // one.
+    iterator lower_bound(commodity_t * comm) {
+      if (large)
+        return large->lower_bound(comm);
+      small_type::iterator i = small.begin();
+      while (i != small.end() && std::less<commodity_t *>()(i->first, comm))
+        ++i;
+      return i;
+    }
+
+    iterator find(commodity_t * comm) {
+      if (large)
+        return large->find(comm);
+      for (small_type::iterator i = small.begin(); i != small.end(); ++i)
+        if (i->first == comm)
+          return i;
+      return small.end();
+    }
+    const_iterator find(commodity_t * comm) const {
+      if (large)
+        return const_iterator(large_type::const_iterator(large->find(comm)));
+      for (small_type::const_iterator i = small.begin(); i != small.end(); ++i)
+        if (i->first == comm)
+          return i;
+      return small.end();
+    }
+
+    /**
+     * insert() adds ENTRY unless its commodity is already present, just
+     * as std::map::insert does.  The form taking a position expects it
+     * to be where lower_bound() says the entry belongs.
+     */
+    std::pair<iterator, bool> insert(const value_type& entry) {
+      iterator i = lower_bound(entry.first);
+      if (i != end() && i->first == entry.first)
+        return std::pair<iterator, bool>(i, false);
+      return std::pair<iterator, bool>(insert(i, entry), true);
+    }
+    iterator insert(iterator pos, const value_type& entry) {
+      if (! large && small.size() < small_limit)
+        return small.insert(pos.in_small, entry);
+      if (! large) {
+        make_large();
+        pos = large->end();
+      }
+      return large->insert(pos.in_large,
+                           large_type::value_type(entry.first, entry));
+    }
+
+    iterator erase(iterator i) {
+      if (large)
+        return large->erase(i.in_large);
+      return small.erase(i.in_small);
+    }
+  };
 
   amounts_map amounts;
 
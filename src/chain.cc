@@ -114,6 +114,12 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
   predicate_t            only_predicate;
   display_filter_posts * display_filter = NULL;
 
+  // The start of the handlers that lead to truncate_xacts for --head.  It
+  // only moves up the chain past handlers known to pass on every posting
+  // they get, so sort_posts keeps all its postings whenever any other
+  // handler comes between them.
+  post_handler_ptr       head_chain;
+
   expr_t& expr(report.HANDLER(amount_).expr);
   expr.set_context(&report);
 
@@ -122,31 +128,39 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
   report.HANDLER(display_total_).expr.set_context(&report);
 
   if (! for_accounts_report) {
-    // Make sure only forecast postings which match are allowed through
-    if (report.HANDLED(forecast_while_)) {
-      handler.reset(new filter_posts
-                    (handler, predicate_t(report.HANDLER(forecast_while_).str(),
-                                          report.what_to_keep()),
-                     report));
-    }
-
     // truncate_xacts cuts off a certain number of _xacts_ from being
     // displayed.  It does not affect calculation.
-    if (report.HANDLED(head_) || report.HANDLED(tail_))
+    if (report.HANDLED(head_) || report.HANDLED(tail_)) {
       handler.reset
         (new truncate_xacts(handler,
                             report.HANDLED(head_) ?
                             lexical_cast<int>(report.HANDLER(head_).value) : 0,
                             report.HANDLED(tail_) ?
                             lexical_cast<int>(report.HANDLER(tail_).value) : 0));
+      if (! report.HANDLED(tail_))
+        head_chain = handler;
+    }
+
+    // Make sure only forecast postings which match are allowed through,
+    // before --head or --tail counts the transactions to show.
+    if (report.HANDLED(forecast_while_)) {
+      handler.reset(new filter_posts
+                    (handler, predicate_t(report.HANDLER(forecast_while_).str(),
+                                          report.what_to_keep()),
+                     report));
+    }
 
     // display_filter_posts adds virtual posts to the list to account
     // for changes in value of commodities, which otherwise would affect
     // the running total unpredictably.
+    post_handler_ptr next(handler);
     display_filter = new display_filter_posts(handler, report,
                                               report.HANDLED(revalued) &&
                                               ! report.HANDLED(no_rounding));
     handler.reset(display_filter);
+    if (head_chain && head_chain == next &&
+        ! report.HANDLED(display_amount_) && ! report.HANDLED(revalued))
+      head_chain = handler;
 
     // filter_posts will only pass through posts matching the
     // `display_predicate'.
@@ -169,9 +183,12 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
   // calc_posts computes the running total.  When this appears will determine,
   // for example, whether filtered posts are included or excluded from the
   // running total.
+  post_handler_ptr next(handler);
   handler.reset(new calc_posts(handler, expr, (! for_accounts_report ||
                                                (report.HANDLED(revalued) &&
                                                 report.HANDLED(unrealized)))));
+  if (head_chain && head_chain == next)
+    head_chain = handler;
 
   // filter_posts will only pass through posts matching the
   // `secondary_predicate'.
@@ -187,8 +204,22 @@ post_handler_ptr chain_post_handlers(post_handler_ptr base_handler,
     if (report.HANDLED(sort_)) {
       if (report.HANDLED(sort_xacts_))
         handler.reset(new sort_xacts(handler, expr_t(report.HANDLER(sort_).str()), report));
-      else
-        handler.reset(new sort_posts(handler, report.HANDLER(sort_).str(), report));
+      else {
+        // When only the first few transactions will be shown, and every
+        // handler between here and truncate_xacts passes on the postings
+        // it is given, but for those with nothing to display, sort_posts
+        // need only keep the postings that can still make it into the
+        // report.  --tail needs every posting ahead of the ones shown for
+        // their running totals, so it always sorts them all.
+        std::size_t limit = 0;
+        if (head_chain == handler) {
+          int count = lexical_cast<int>(report.HANDLER(head_).value);
+          if (count > 0)
+            limit = static_cast<std::size_t>(count);
+        }
+        handler.reset(new sort_posts(handler, report.HANDLER(sort_).str(),
+                                     report, limit));
+      }
     }
 
     // collapse_posts causes xacts with multiple posts to appear as xacts
@@ -58,8 +58,6 @@ void commodity_t::add_price(const datetime_t& date, const amount_t& price,
         << " for " << price << " on " << date);
 
   pool().commodity_price_history.add_price(referent(), date, price);
-
-  base->price_map.clear();    // a price was added, invalid the map
 }
 
 void commodity_t::remove_price(const datetime_t& date, commodity_t& commodity)
@@ -67,8 +65,6 @@ void commodity_t::remove_price(const datetime_t& date, commodity_t& commodity)
   pool().commodity_price_history.remove_price(referent(), commodity, date);
 
   DEBUG("history.find", "Removing price: " << symbol() << " on " << date);
-
-  base->price_map.clear();  // a price was added, invalid the map
 }
 
 void commodity_t::map_prices(function<void(datetime_t, const amount_t&)> fn,
@@ -138,13 +134,26 @@ commodity_t::find_price(const commodity_t * commodity,
         << (! moment.is_not_a_date_time() ? format_datetime(moment) : "NONE") << ", "
         << (! oldest.is_not_a_date_time() ? format_datetime(oldest) : "NONE") << ", "
         << (commodity ? commodity->symbol()      : "NONE"));
-  {
-    base_t::memoized_price_map::iterator i = base->price_map.find(entry);
-    if (i != base->price_map.end()) {
-      DEBUG("commodity.price.find", "found! returning: "
-            << ((*i).second ? (*i).second->price : amount_t(0L)));
-      return (*i).second;
-    }
+  pool().price_lookups++;
+
+  std::size_t generation = pool().commodity_price_history.generation();
+  if (base->price_map_generation != generation) {
+    // A price has been added or removed since these were remembered
+    base->price_map.clear();
+    base->price_list.clear();
+    base->price_map_generation = generation;
+  }
+
+  base_t::memoized_price_map::iterator i = base->price_map.find(entry);
+  if (i != base->price_map.end()) {
+    base->price_list.splice(base->price_list.begin(), base->price_list,
+                            (*i).second);
+    pool().price_lookups_cached++;
+
+    const optional<price_point_t>& point((*(*i).second).second);
+    DEBUG("commodity.price.find", "found! returning: "
+          << (point ? point->price : amount_t(0L)));
+    return point;
   }
 
   datetime_t when;
@@ -165,16 +174,18 @@ commodity_t::find_price(const commodity_t * commodity,
           pool().commodity_price_history.find_price(referent(), when, oldest));
 
   // Record this price point in the memoization map
-  if (base->price_map.size() > base_t::max_price_map_size) {
+  if (base->price_map.size() >= base_t::max_price_map_size) {
     DEBUG("history.find",
-          "price map has grown too large, clearing it by half");
-    for (std::size_t i = 0; i < base_t::max_price_map_size >> 1; i++)
-      base->price_map.erase(base->price_map.begin());
+          "price map is full, forgetting the least recently used price");
+    base->price_map.erase(base->price_list.back().first);
+    base->price_list.pop_back();
   }
 
   DEBUG("history.find",
         "remembered: " << (point ? point->price : amount_t(0L)));
-  base->price_map.insert(base_t::memoized_price_map::value_type(entry, point));
+  base->price_list.push_front(std::make_pair(entry, point));
+  base->price_map.insert(base_t::memoized_price_map::value_type
+                         (entry, base->price_list.begin()));
 
   return point;
 }
@@ -364,6 +375,62 @@ void commodity_t::parse_symbol(std::istream& in, string& symbol)
   }
 }
 
+bool commodity_t::scan_symbol(const char *& p, const char * end,
+                              string& symbol)
+{
+  const char * q = p;
+  while (q < end && std::isspace(*q))
+    q++;
+
+  if (q < end && *q == '"')
+    return false;
+
+  const char * start = q;
+  while (q < end && *q != '\n') {
+    unsigned char d = static_cast<unsigned char>(*q);
+
+    std::size_t bytes = 0;
+    if (d >= 192 && d <= 223)
+      bytes = 2;
+    else if (d >= 224 && d <= 239)
+      bytes = 3;
+    else if (d >= 240 && d <= 247)
+      bytes = 4;
+    else if (d >= 248 && d <= 251)
+      bytes = 5;
+    else if (d >= 252 && d <= 253)
+      bytes = 6;
+    else if (d >= 254)
+      break;
+
+    if (bytes > 0) {
+      if (static_cast<std::size_t>(end - q) < bytes)
+        return false;
+      q += bytes;
+    }
+    else if (invalid_chars[d]) {
+      break;
+    }
+    else if (d == '\\') {
+      return false;
+    }
+    else {
+      q++;
+    }
+
+    if (q - start > 200)
+      return false;
+  }
+
+  symbol.assign(start, static_cast<string::size_type>(q - start));
+  if (is_reserved_token(symbol.c_str()))
+    symbol.clear();
+
+  if (! symbol.empty())
+    p = q;
+  return true;
+}
+
 void commodity_t::parse_symbol(char *& p, string& symbol)
 {
   if (*p == '"') {
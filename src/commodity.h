@@ -106,13 +106,23 @@ protected:
     optional<amount_t>    larger;
     optional<expr_t>      value_expr;
 
+    // find_price remembers its most recent answers, keeping those used
+    // most recently at the front of price_list.  They are forgotten when
+    // any price is added or removed, since that may change any of them.
+    // Like the price history they come from, they are not synchronized,
+    // so prices must be looked up on one thread at a time.
     typedef tuple<datetime_t, datetime_t,
                   const commodity_t *> memoized_price_entry;
+    typedef std::list<std::pair<memoized_price_entry,
+                                optional<price_point_t> > >
+      memoized_price_list;
     typedef std::map<memoized_price_entry,
-                     optional<price_point_t> > memoized_price_map;
+                     memoized_price_list::iterator> memoized_price_map;
 
-    static const std::size_t   max_price_map_size = 8;
-    mutable memoized_price_map price_map;
+    static const std::size_t    max_price_map_size = 64;
+    mutable memoized_price_list price_list;
+    mutable memoized_price_map  price_map;
+    mutable std::size_t         price_map_generation;
 
   public:
     explicit base_t(const string& _symbol)
@@ -120,7 +130,7 @@ protected:
         (commodity_t::decimal_comma_by_default ?
          static_cast<uint_least16_t>(COMMODITY_STYLE_DECIMAL_COMMA) :
          static_cast<uint_least16_t>(COMMODITY_STYLE_DEFAULTS)),
-        symbol(_symbol), precision(0) {
+        symbol(_symbol), precision(0), price_map_generation(0) {
       TRACE_CTOR(commodity_t::base_t, "const string&");
     }
     virtual ~base_t() {
@@ -268,6 +278,12 @@ public:
 
   static void parse_symbol(std::istream& in, string& symbol);
   static void parse_symbol(char *& p, string& symbol);
+
+  // Reads a symbol from [P, END) exactly as parse_symbol(std::istream&)
+  // would, advancing P past it.  Returns false, leaving P alone, for the
+  // rarer forms (quoted or escaped symbols, overlong or truncated ones)
+  // which only the stream version handles.
+  static bool scan_symbol(const char *& p, const char * end, string& symbol);
   static string parse_symbol(std::istream& in) {
     string temp;
     parse_symbol(in, temp);
@@ -44,10 +44,10 @@
 
 #include "utils.h"
 #include "times.h"
+#include "journal.h"
 
 namespace ledger {
 
-class journal_t;
 class account_t;
 class scope_t;
 
@@ -70,15 +70,17 @@ public:
   std::size_t      errors;
   std::size_t      count;
   std::size_t      sequence;
+  bool             resumable;
 
   explicit parse_context_t(const path& cwd)
-    : current_directory(cwd), master(NULL), scope(NULL),
-      linenum(0), errors(0), count(0), sequence(1) {}
+    : current_directory(cwd), journal(NULL), master(NULL), scope(NULL),
+      linenum(0), errors(0), count(0), sequence(1), resumable(false) {}
 
   explicit parse_context_t(shared_ptr<std::istream> _stream,
                            const path& cwd)
-    : stream(_stream), current_directory(cwd), master(NULL),
-      scope(NULL), linenum(0), errors(0), count(0), sequence(1) {}
+    : stream(_stream), current_directory(cwd), journal(NULL), master(NULL),
+      scope(NULL), linenum(0), errors(0), count(0), sequence(1),
+      resumable(false) {}
 
   parse_context_t(const parse_context_t& context)
    : stream(context.stream),
@@ -92,7 +94,8 @@ public:
      linenum(context.linenum),
      errors(context.errors),
      count(context.count),
-     sequence(context.sequence) {
+     sequence(context.sequence),
+     resumable(context.resumable) {
     std::memcpy(linebuf, context.linebuf, MAX_LINE);
   }
 
@@ -100,16 +103,23 @@ public:
     return file_context(pathname, linenum);
   }
 
+  // A journal whose parsing gave warnings is not cached, so that the
+  // warnings are seen again each time it is read.
   void warning(const string& what) const {
+    if (journal)
+      journal->cacheable = false;
     warning_func(location() + " " + what);
   }
   void warning(const boost::format& what) const {
+    if (journal)
+      journal->cacheable = false;
     warning_func(location() + " " + string(what.str()));
   }
 };
 
-inline parse_context_t open_for_reading(const path& pathname,
-                                        const path& cwd)
+// The absolute name of a journal file as it will be opened, which --cache
+// also uses to key its archive on the files read.
+inline path journal_path_for_reading(const path& pathname, const path& cwd)
 {
   path filename = resolve_path(pathname);
 #if BOOST_VERSION >= 104600 && BOOST_FILESYSTEM_VERSION >= 3
@@ -120,6 +130,13 @@ inline parse_context_t open_for_reading(const path& pathname,
   if (! exists(filename) || is_directory(filename))
     throw_(std::runtime_error,
            _f("Cannot read journal file %1%") % filename);
+  return filename;
+}
+
+inline parse_context_t open_for_reading(const path& pathname,
+                                        const path& cwd)
+{
+  path filename = journal_path_for_reading(pathname, cwd);
 
   path parent(filename.parent_path());
   shared_ptr<std::istream> stream(new ifstream(filename));
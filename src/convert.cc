@@ -59,6 +59,13 @@ value_t convert_command(call_scope_t& args)
   // Create a flat list
   xacts_list current_xacts(journal.xacts_begin(), journal.xacts_end());
 
+  // The payees of the transactions already in the journal are indexed
+  // once, for matching against every transaction read.
+  scoped_ptr<payee_index_t> payees;
+  if (report.HANDLED(auto_match))
+    payees.reset(new payee_index_t(current_xacts.rbegin(),
+                                   current_xacts.rend()));
+
   // Read in the series of transactions from the CSV file
 
   print_xacts formatter(report);
@@ -96,9 +103,8 @@ value_t convert_command(call_scope_t& args)
 
       if (xact->posts.front()->account == NULL) {
         if (account_t * acct =
-            (report.HANDLED(auto_match) ?
-             lookup_probable_account(xact->payee, current_xacts.rbegin(),
-                                     current_xacts.rend(), bucket).second :
+            (payees ?
+             payees->lookup_probable_account(xact->payee, bucket).second :
              NULL))
           xact->posts.front()->account = acct;
         else
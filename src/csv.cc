@@ -185,17 +185,11 @@ xact_t * csv_reader::read_xact(bool rich_data)
       break;
 
     case FIELD_PAYEE: {
-      bool found = false;
-      foreach (payee_alias_mapping_t& value, context.journal->payee_alias_mappings) {
-        DEBUG("csv.mappings", "Looking for payee mapping: " << value.first);
-        if (value.first.match(field)) {
-          xact->payee = value.second;
-          found = true;
-          break;
-        }
-      }
-      if (! found)
-        xact->payee = field;
+      const payee_alias_mapping_t * alias =
+        context.journal->find_payee_alias(field);
+      DEBUG("csv.mappings", "Payee mapping for " << field << ": "
+            << (alias ? alias->first.str() : string("none")));
+      xact->payee = alias ? alias->second : field;
       break;
     }
 
@@ -245,12 +239,9 @@ xact_t * csv_reader::read_xact(bool rich_data)
 
   // Translate the account name, if we have enough information to do so
 
-  foreach (account_mapping_t& value, context.journal->payees_for_unknown_accounts) {
-    if (value.first.match(xact->payee)) {
-      post->account = value.second;
-      break;
-    }
-  }
+  if (account_t * account =
+      context.journal->find_account_for_payee(xact->payee))
+    post->account = account;
 
   xact->add_post(post.release());
 
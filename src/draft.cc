@@ -242,23 +242,18 @@ xact_t * draft_t::insert(journal_t& journal)
   xact_t *              matching = NULL;
   unique_ptr<xact_t> added(new xact_t);
 
+  payee_index_t payees(journal.xacts.rbegin(), journal.xacts.rend());
+
   if (xact_t * xact =
-      lookup_probable_account(tmpl->payee_mask.str(), journal.xacts.rbegin(),
-                              journal.xacts.rend()).first) {
+      payees.lookup_probable_account(tmpl->payee_mask.str()).first) {
     DEBUG("draft.xact", "Found payee by lookup: transaction on line "
           << xact->pos->beg_line);
     matching = xact;
-  } else {
-    for (xacts_list::reverse_iterator j = journal.xacts.rbegin();
-         j != journal.xacts.rend();
-         j++) {
-      if (tmpl->payee_mask.match((*j)->payee)) {
-        matching = *j;
-        DEBUG("draft.xact",
-              "Found payee match: transaction on line " << (*j)->pos->beg_line);
-        break;
-      }
-    }
+  }
+  else if (xact_t * xact = payees.find_payee(tmpl->payee_mask)) {
+    matching = xact;
+    DEBUG("draft.xact",
+          "Found payee match: transaction on line " << xact->pos->beg_line);
   }
 
   if (! tmpl->date) {
@@ -33,27 +33,29 @@
 
 #include "expr.h"
 #include "parser.h"
+#include "program.h"
 #include "scope.h"
 
 namespace ledger {
 
-expr_t::expr_t() : base_type()
+expr_t::expr_t() : base_type(), evaluations(0)
 {
   TRACE_CTOR(expr_t, "");
 }
 
-expr_t::expr_t(const expr_t& other) : base_type(other), ptr(other.ptr)
+expr_t::expr_t(const expr_t& other)
+  : base_type(other), ptr(other.ptr), evaluations(0)
 {
   TRACE_CTOR(expr_t, "copy");
 }
 expr_t::expr_t(ptr_op_t _ptr, scope_t * _context)
-  : base_type(_context), ptr(_ptr)
+  : base_type(_context), ptr(_ptr), evaluations(0)
 {
   TRACE_CTOR(expr_t, "const ptr_op_t&, scope_t *");
 }
 
 expr_t::expr_t(const string& _str, const parse_flags_t& flags)
-  : base_type()
+  : base_type(), evaluations(0)
 {
   if (! _str.empty())
     parse(_str, flags);
@@ -61,7 +63,7 @@ expr_t::expr_t(const string& _str, const parse_flags_t& flags)
 }
 
 expr_t::expr_t(std::istream& in, const parse_flags_t& flags)
-  : base_type()
+  : base_type(), evaluations(0)
 {
   parse(in, flags);
   TRACE_CTOR(expr_t, "std::istream&, parse_flags_t");
@@ -76,6 +78,8 @@ expr_t& expr_t::operator=(const expr_t& _expr)
   if (this != &_expr) {
     base_type::operator=(_expr);
     ptr = _expr.ptr;
+    program.reset();
+    evaluations = 0;
   }
   return *this;
 }
@@ -96,6 +100,8 @@ void expr_t::parse(std::istream& in, const parse_flags_t& flags,
   parser_t parser;
   istream_pos_type start_pos = in.tellg();
   ptr = parser.parse(in, flags, original_string);
+  program.reset();
+  evaluations = 0;
   istream_pos_type end_pos = in.tellg();
 
   if (original_string) {
@@ -120,6 +126,8 @@ void expr_t::compile(scope_t& scope)
 {
   if (! compiled && ptr) {
     ptr = ptr->compile(scope);
+    program.reset();
+    evaluations = 0;
     base_type::compile(scope);
   }
 }
@@ -127,8 +135,20 @@ void expr_t::compile(scope_t& scope)
 value_t expr_t::real_calc(scope_t& scope)
 {
   if (ptr) {
+    // Expressions evaluated more than once are lowered into a flat
+    // program; the tree walker handles the first call, and any tree
+    // that lowering cannot improve upon.
+    if (compiled && ! program && ++evaluations == 2)
+      program = program_t::lower(ptr);
+
     ptr_op_t locus;
     try {
+      if (program && program->get_root() == ptr
+#if DEBUG_ON
+          && ! SHOW_DEBUG("expr.calc")
+#endif
+          )
+        return program->run(scope, &locus);
       return ptr->calc(scope, &locus);
     }
     catch (const std::exception&) {
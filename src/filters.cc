@@ -151,19 +151,246 @@ void truncate_xacts::operator()(post_t& post)
   posts.push_back(&post);
 }
 
+namespace {
+  // Below this many elements, splitting a sort across threads costs more
+  // than it saves.
+  const std::size_t parallel_sort_threshold = 16384;
+
+  template <typename Iterator, typename Compare>
+  void parallel_stable_sort(Iterator begin, Iterator end, Compare compare,
+                            std::size_t threads)
+  {
+    if (threads < 2 ||
+        static_cast<std::size_t>(end - begin) < parallel_sort_threshold) {
+      std::stable_sort(begin, end, compare);
+      return;
+    }
+
+    // Sort each half on its own thread, then merge them; the merge keeps
+    // elements of the first half ahead of equal ones from the second.
+    Iterator middle = begin + (end - begin) / 2;
+    std::future<void> first_half =
+      std::async(std::launch::async,
+                 parallel_stable_sort<Iterator, Compare>,
+                 begin, middle, compare, threads / 2);
+    parallel_stable_sort(middle, end, compare, threads - threads / 2);
+    first_half.get();
+
+    std::inplace_merge(begin, middle, end, compare);
+  }
+
+  class compare_sort_keys
+  {
+    const std::vector<sort_value_t>& keys;
+    std::size_t                      width;
+
+  public:
+    compare_sort_keys(const std::vector<sort_value_t>& _keys,
+                      std::size_t _width)
+      : keys(_keys), width(_width) {}
+
+    bool operator()(std::size_t left, std::size_t right) const {
+      return sort_value_is_less_than(&keys[left * width],
+                                     &keys[right * width], width);
+    }
+  };
+
+  // Whether comparing VALUE with another value of the same type only
+  // reads the two, so that it may happen on several threads at once.
+  // Comparing balances, sequences or annotated amounts goes through their
+  // commodities and the annotations kept by the commodity pool, and values
+  // of mixed types are first converted to a common type; none of that is
+  // synchronized.
+  bool thread_safe_sort_key(const value_t& value, value_t::type_t type)
+  {
+    if (value.type() != type)
+      return false;
+
+    switch (type) {
+    case value_t::BOOLEAN:
+    case value_t::INTEGER:
+    case value_t::DATETIME:
+    case value_t::DATE:
+    case value_t::STRING:
+      return true;
+    case value_t::AMOUNT:
+      return ! value.as_amount().has_annotation();
+    default:
+      return false;
+    }
+  }
+}
+
 void sort_posts::post_accumulated_posts()
 {
-  std::stable_sort(posts.begin(), posts.end(),
-                   compare_items<post_t>(sort_order, report));
+  // Work out every posting's sort key exactly once, into one contiguous
+  // array.  Value expressions may update posting and account xdata and
+  // the commodity price caches as they run, so this happens on this
+  // thread; only the sorting itself is spread over --threads, and only
+  // when every key can be compared without touching shared state.
+  compare_items<post_t>     compare(sort_order, report);
+  std::vector<sort_value_t> keys;
+  std::size_t               width     = 0;
+  bool                      separable = true;
 
   foreach (post_t * post, posts) {
-    post->xdata().drop_flags(POST_EXT_SORT_CALC);
-    item_handler<post_t>::operator()(*post);
+    std::list<sort_value_t> values;
+    bind_scope_t bound_scope(*sort_order.get_context(), *post);
+    compare.find_sort_values(values, bound_scope);
+
+    if (keys.empty()) {
+      width = values.size();
+      keys.reserve(width * posts.size());
+    }
+    assert(values.size() == width);
+    keys.insert(keys.end(), values.begin(), values.end());
+
+    for (std::size_t i = keys.size() - width;
+         separable && i < keys.size();
+         i++)
+      separable = thread_safe_sort_key(keys[i].value,
+                                       keys[i % width].value.type());
   }
 
+  std::vector<std::size_t> order(posts.size());
+  for (std::size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  std::size_t threads = 1;
+  if (separable && report.HANDLED(threads_))
+    threads = lexical_cast<std::size_t>(report.HANDLER(threads_).str());
+#if DEBUG_ON
+  // Debugging output prints the values compared, which is not safe on
+  // several threads.
+  if (SHOW_DEBUG("value.sort"))
+    threads = 1;
+#endif
+  DEBUG("filters.sort", "Sorting " << posts.size() << " postings on "
+        << threads << " threads");
+
+  parallel_stable_sort(order.begin(), order.end(),
+                       compare_sort_keys(keys, width), threads);
+
+  foreach (std::size_t index, order)
+    item_handler<post_t>::operator()(*posts[index]);
+
   posts.clear();
 }
 
+bool sort_posts::compare_kept::operator()(xact_t * left, xact_t * right) const
+{
+  return sorter.precedes(sorter.kept.find(left)->second.best,
+                         sorter.kept.find(right)->second.best);
+}
+
+bool sort_posts::precedes(const sort_entry_t& left,
+                          const sort_entry_t& right) const
+{
+  // The order a full stable sort gives.
+  const std::size_t width = left.values.size();
+  if (sort_value_is_less_than(left.values.data(), right.values.data(), width))
+    return true;
+  if (sort_value_is_less_than(right.values.data(), left.values.data(), width))
+    return false;
+  return left.seq < right.seq;
+}
+
+void sort_posts::discard(const sort_entry_t& entry)
+{
+  if (! discarded || precedes(entry, first_discarded)) {
+    first_discarded = entry;
+
+    // Postings with nothing to display only matter ahead of the cut.
+    hidden.erase(hidden.lower_bound(first_discarded), hidden.end());
+  }
+  discarded = true;
+}
+
+void sort_posts::keep_post(post_t& post)
+{
+  if (! sort_keys)
+    sort_keys.reset(new compare_items<post_t>(sort_order, report));
+
+  sort_entry_t entry;
+  entry.post = &post;
+  entry.seq  = seen++;
+
+  sort_values.clear();
+  bind_scope_t bound_scope(*sort_order.get_context(), post);
+  sort_keys->find_sort_values(sort_values, bound_scope);
+  entry.values.assign(sort_values.begin(), sort_values.end());
+
+  // Postings with nothing to display are dropped by display_filter_posts
+  // further down the chain, so they take no place in the ranking; but they
+  // still count towards the running totals computed before then.
+  if (! report.HANDLED(empty)) {
+    bind_scope_t display_scope(report, post);
+    if (! report.HANDLER(display_amount_).expr.calc(display_scope)
+          .strip_annotations(report.what_to_keep())) {
+      if (! discarded || precedes(entry, first_discarded))
+        hidden.insert(entry);
+      return;
+    }
+  }
+
+  kept_xacts_map::iterator i = kept.find(post.xact);
+  if (i != kept.end()) {
+    if (precedes(entry, (*i).second.best)) {
+      ranking.erase(post.xact);
+      (*i).second.best = entry;
+      ranking.insert(post.xact);
+    }
+    (*i).second.entries.push_back(entry);
+    return;
+  }
+
+  // One transaction more than is shown is kept, so that the last one shown
+  // is known to be complete: see post_kept_posts.
+  if (ranking.size() > limit) {
+    xact_t *     worst_xact = *ranking.rbegin();
+    kept_xact_t& worst(kept.find(worst_xact)->second);
+
+    if (! precedes(entry, worst.best)) {
+      discard(entry);
+      return;
+    }
+
+    discard(worst.best);
+    ranking.erase(worst_xact);
+    kept.erase(worst_xact);
+  }
+
+  kept_xact_t& xact(kept[post.xact]);
+  xact.best = entry;
+  xact.entries.push_back(entry);
+  ranking.insert(post.xact);
+}
+
+void sort_posts::post_kept_posts()
+{
+  // Every posting that sorts ahead of the first discarded one was kept, so
+  // the kept postings ahead of it are exactly how a full sort would begin.
+  // The best posting of each of the LIMIT + 1 kept transactions lies ahead
+  // of it, so that beginning holds LIMIT whole runs of postings from one
+  // transaction, which is all truncate_xacts will pass on.
+  std::vector<const sort_entry_t *> entries;
+  foreach (const kept_xacts_map::value_type& pair, kept)
+    foreach (const sort_entry_t& entry, pair.second.entries)
+      if (! discarded || precedes(entry, first_discarded))
+        entries.push_back(&entry);
+  foreach (const sort_entry_t& entry, hidden)
+    entries.push_back(&entry);
+
+  std::sort(entries.begin(), entries.end(), compare_kept(*this));
+
+  foreach (const sort_entry_t * entry, entries)
+    item_handler<post_t>::operator()(*entry->post);
+
+  ranking.clear();
+  kept.clear();
+  hidden.clear();
+}
+
 namespace {
   void split_string(const string& str, const char ch,
                     std::list<string>& strings)
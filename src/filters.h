@@ -47,6 +47,7 @@
 #include "post.h"
 #include "account.h"
 #include "temps.h"
+#include "compare.h"
 
 namespace ledger {
 
@@ -235,22 +236,78 @@ class sort_posts : public item_handler<post_t>
 {
   typedef std::deque<post_t *> posts_deque;
 
-  posts_deque posts;
-  expr_t      sort_order;
-  report_t&   report;
+  // When the report only shows the first LIMIT transactions of the sorted
+  // postings, just the postings of the LIMIT + 1 transactions that sort
+  // furthest forward are kept together with their keys.
+  struct sort_entry_t {
+    post_t *                  post;
+    std::size_t               seq;
+    std::vector<sort_value_t> values;
+  };
+
+  struct kept_xact_t {
+    std::vector<sort_entry_t> entries;
+    sort_entry_t              best;
+  };
+
+  class compare_kept
+  {
+    const sort_posts& sorter;
+
+  public:
+    compare_kept(const sort_posts& _sorter) : sorter(_sorter) {}
+
+    bool operator()(xact_t * left, xact_t * right) const;
+    bool operator()(const sort_entry_t& left,
+                    const sort_entry_t& right) const {
+      return sorter.precedes(left, right);
+    }
+    bool operator()(const sort_entry_t * left,
+                    const sort_entry_t * right) const {
+      return sorter.precedes(*left, *right);
+    }
+  };
+
+  typedef std::map<xact_t *, kept_xact_t>         kept_xacts_map;
+  typedef std::set<xact_t *, compare_kept>       kept_xacts_set;
+  typedef std::set<sort_entry_t, compare_kept>   sort_entries_set;
+
+  posts_deque    posts;
+  expr_t         sort_order;
+  report_t&      report;
+  std::size_t    limit;
+  kept_xacts_map kept;
+  kept_xacts_set ranking;
+  sort_entries_set hidden;  // kept postings with nothing to display
+  std::size_t    seen;
+  bool           discarded;
+  sort_entry_t   first_discarded;
+
+  unique_ptr<compare_items<post_t> > sort_keys;
+  std::list<sort_value_t>            sort_values;
 
   sort_posts();
 
+  bool precedes(const sort_entry_t& left, const sort_entry_t& right) const;
+  void discard(const sort_entry_t& entry);
+  void keep_post(post_t& post);
+  void post_kept_posts();
+
 public:
   sort_posts(post_handler_ptr handler, const expr_t& _sort_order,
              report_t& _report)
-    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report) {
+    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report),
+      limit(0), ranking(compare_kept(*this)), hidden(compare_kept(*this)),
+      seen(0), discarded(false) {
     TRACE_CTOR(sort_posts, "post_handler_ptr, const value_expr&, report_t&");
   }
   sort_posts(post_handler_ptr handler, const string& _sort_order,
-             report_t& _report)
-    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report) {
-    TRACE_CTOR(sort_posts, "post_handler_ptr, const string&, report_t&");
+             report_t& _report, std::size_t _limit = 0)
+    : item_handler<post_t>(handler), sort_order(_sort_order), report(_report),
+      limit(_limit), ranking(compare_kept(*this)),
+      hidden(compare_kept(*this)), seen(0), discarded(false) {
+    TRACE_CTOR(sort_posts,
+               "post_handler_ptr, const string&, report_t&, std::size_t");
   }
   virtual ~sort_posts() {
     TRACE_DTOR(sort_posts);
@@ -259,16 +316,28 @@ public:
   virtual void post_accumulated_posts();
 
   virtual void flush() {
-    post_accumulated_posts();
+    if (limit)
+      post_kept_posts();
+    else
+      post_accumulated_posts();
     item_handler<post_t>::flush();
   }
 
   virtual void operator()(post_t& post) {
-    posts.push_back(&post);
+    if (limit)
+      keep_post(post);
+    else
+      posts.push_back(&post);
   }
 
   virtual void clear() {
     posts.clear();
+    ranking.clear();
+    kept.clear();
+    hidden.clear();
+    sort_keys.reset();
+    seen      = 0;
+    discarded = false;
     sort_order.mark_uncompiled();
 
     item_handler<post_t>::clear();
@@ -396,13 +396,59 @@ format_t::element_t * format_t::parse_elements(const string& fmt,
   return result.release();
 }
 
+value_t format_t::element_t::calc(scope_t& scope)
+{
+  expr_t& expr(boost::get<expr_t>(data));
+  try {
+    expr.compile(scope);
+
+    value_t value;
+    if (expr.is_function()) {
+      call_scope_t args(scope);
+      args.push_back(long(max_width));
+      value = expr.get_function()(args);
+    } else {
+      value = expr.calc(scope);
+    }
+    DEBUG("format.expr", "value = (" << value << ")");
+    return value;
+  }
+  catch (const calc_error&) {
+    string current_context = error_context();
+
+    add_error_context(_("While calculating format expression:"));
+    add_error_context(expr.context_to_str());
+
+    if (! current_context.empty())
+      add_error_context(current_context);
+    throw;
+  }
+}
+
 string format_t::real_calc(scope_t& scope)
 {
-  std::ostringstream out_str;
+  string result;
+  render(scope, result);
+  return result;
+}
 
+void format_t::render(scope_t& scope, string& buf)
+{
   for (element_t * elem = elements.get(); elem; elem = elem->next.get()) {
+    if (elem->max_width == 0 && elem->min_width == 0) {
+      if (elem->type == element_t::STRING) {
+        buf += boost::get<string>(elem->data);
+      } else {
+        value_t value(elem->calc(scope));
+        if (value.is_string())
+          buf += value.as_string();
+        else
+          buf += value.to_string();
+      }
+      continue;
+    }
+
     std::ostringstream out;
-    string name;
 
     if (elem->has_flags(ELEMENT_ALIGN_LEFT))
       out << std::left;
@@ -411,65 +457,31 @@ string format_t::real_calc(scope_t& scope)
 
     switch (elem->type) {
     case element_t::STRING:
-      if (elem->min_width > 0)
-        out.width(static_cast<std::streamsize>(elem->min_width));
+      out.width(static_cast<std::streamsize>(elem->min_width));
       out << boost::get<string>(elem->data);
       break;
 
     case element_t::EXPR: {
-      expr_t& expr(boost::get<expr_t>(elem->data));
-      try {
-        expr.compile(scope);
-
-        value_t value;
-        if (expr.is_function()) {
-          call_scope_t args(scope);
-          args.push_back(long(elem->max_width));
-          value = expr.get_function()(args);
-        } else {
-          value = expr.calc(scope);
-        }
-        DEBUG("format.expr", "value = (" << value << ")");
-
-        if (elem->min_width > 0)
-          value.print(out, static_cast<int>(elem->min_width), -1,
-                      ! elem->has_flags(ELEMENT_ALIGN_LEFT));
-        else
-          out << value.to_string();
-      }
-      catch (const calc_error&) {
-        string current_context = error_context();
-
-        add_error_context(_("While calculating format expression:"));
-        add_error_context(expr.context_to_str());
-
-        if (! current_context.empty())
-          add_error_context(current_context);
-        throw;
-      }
+      value_t value(elem->calc(scope));
+      if (elem->min_width > 0)
+        value.print(out, static_cast<int>(elem->min_width), -1,
+                    ! elem->has_flags(ELEMENT_ALIGN_LEFT));
+      else
+        out << value.to_string();
       break;
     }
     }
 
-    if (elem->max_width > 0 || elem->min_width > 0) {
-      unistring temp(out.str());
-      string    result;
+    unistring temp(out.str());
 
-      if (elem->max_width > 0 && elem->max_width < temp.length()) {
-        result = truncate(temp, elem->max_width);
-      } else {
-        result = temp.extract();
-        if (elem->min_width > temp.length())
-          for (std::size_t i = 0; i < elem->min_width - temp.length(); i++)
-            result += " ";
-      }
-      out_str << result;
+    if (elem->max_width > 0 && elem->max_width < temp.length()) {
+      buf += truncate(temp, elem->max_width);
     } else {
-      out_str << out.str();
+      buf += temp.extract();
+      if (elem->min_width > temp.length())
+        buf.append(elem->min_width - temp.length(), ' ');
     }
   }
-
-  return out_str.str();
 }
 
 string format_t::truncate(const unistring&  ustr,
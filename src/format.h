@@ -100,6 +100,8 @@ class format_t : public expr_base_t<string>, public noncopyable
         out.width(static_cast<std::streamsize>(elem->min_width));
     }
 
+    value_t calc(scope_t& scope);
+
     void dump(std::ostream& out) const;
   };
 
@@ -119,6 +121,8 @@ private:
   static element_t * parse_elements(const string& fmt,
                                     const optional<format_t&>& tmpl);
 
+  void render(scope_t& scope, string& buf);
+
 public:
   format_t() : base_type() {
     TRACE_CTOR(format_t, "");
@@ -150,6 +154,15 @@ public:
 
   virtual result_type real_calc(scope_t& scope);
 
+  // Append what calc would return to BUF.  Elements with no width of
+  // their own, which covers the built-in report formats, are appended
+  // directly, without going through a stream.
+  void calc_into(scope_t& scope, string& buf) {
+    if (! compiled)
+      compile(scope);
+    render(scope, buf);
+  }
+
   virtual void dump(std::ostream& out) const {
     for (const element_t * elem = elements.get();
          elem;
@@ -39,8 +39,12 @@ namespace ledger {
 generate_posts_iterator::generate_posts_iterator
   (session_t&   _session,
    unsigned int _seed,
-   std::size_t  _quantity)
+   std::size_t  _quantity,
+   std::size_t  _accounts,
+   std::size_t  _commodities,
+   int          _cost_percent)
   : session(_session), seed(_seed), quantity(_quantity),
+    cost_percent(_cost_percent),
 
     rnd_gen(seed == 0 ? static_cast<unsigned int>(std::time(0)) : seed),
 
@@ -57,6 +61,7 @@ generate_posts_iterator::generate_posts_iterator
     six_range(1, 6), six_gen(rnd_gen, six_range),
     two_six_range(2, 6), two_six_gen(rnd_gen, two_six_range),
     strlen_range(1, 40), strlen_gen(rnd_gen, strlen_range),
+    percent_range(1, 100), percent_gen(rnd_gen, percent_range),
 
     neg_number_range(-10000, -1), neg_number_gen(rnd_gen, neg_number_range),
     pos_number_range(1, 10000), pos_number_gen(rnd_gen, pos_number_range)
@@ -69,9 +74,38 @@ generate_posts_iterator::generate_posts_iterator
   generate_date(next_aux_date_buf);
   next_aux_date = parse_date(next_aux_date_buf.str());
 
+  for (std::size_t i = 0; i < _accounts; i++) {
+    std::ostringstream buf;
+    generate_string(buf, strlen_gen());
+    account_pool.push_back(buf.str());
+  }
+
+  // Fill the commodity pool only once it is complete, since
+  // generate_commodity draws from the pool whenever it is not empty.
+  std::vector<string> symbols;
+  std::set<string>    seen;
+  while (symbols.size() < _commodities) {
+    std::ostringstream buf;
+    generate_commodity(buf);
+    if (seen.insert(buf.str()).second)
+      symbols.push_back(buf.str());
+  }
+  commodity_pool.swap(symbols);
+
+  // Generate the first transaction, so that the iterator does not look
+  // exhausted before it has begun.
+  increment();
+
   TRACE_CTOR(generate_posts_iterator, "bool");
 }
 
+const string&
+generate_posts_iterator::choose(const std::vector<string>& pool)
+{
+  uniform_int<std::size_t> index_range(0, pool.size() - 1);
+  return pool[index_range(rnd_gen)];
+}
+
 void generate_posts_iterator::generate_string(std::ostream& out, int len,
                                               bool only_alpha)
 {
@@ -148,7 +182,10 @@ bool generate_posts_iterator::generate_account(std::ostream& out,
     }
   }
 
-  generate_string(out, strlen_gen());
+  if (account_pool.empty())
+    generate_string(out, strlen_gen());
+  else
+    out << choose(account_pool);
 
   if (is_virtual) {
     if (must_balance)
@@ -164,6 +201,18 @@ void generate_posts_iterator::generate_commodity(std::ostream& out,
                                                  const string& exclude)
 {
   string comm;
+
+  if (commodity_pool.size() > 1 ||
+      (commodity_pool.size() == 1 && commodity_pool.front() != exclude)) {
+    do {
+      comm = choose(commodity_pool);
+    }
+    while (comm == exclude);
+
+    out << comm;
+    return;
+  }
+
   do {
     std::ostringstream buf;
     generate_string(buf, six_gen(), true);
@@ -239,7 +288,7 @@ bool generate_posts_iterator::generate_post(std::ostream& out, bool no_amount)
 
   if (! no_amount) {
     value_t amount(generate_amount(out));
-    if (truth_gen())
+    if (cost_percent < 0 ? truth_gen() : percent_gen() <= cost_percent)
       generate_cost(out, amount);
   }
   if (truth_gen())
@@ -365,7 +414,7 @@ void generate_posts_iterator::increment()
       parsing_context.get_current().journal = session.journal.get();
       parsing_context.get_current().scope   = &session;
 
-      if (session.journal->read(parsing_context) != 0) {
+      if (session.journal->read(parsing_context, true) != 0) {
         VERIFY(session.journal->xacts.back()->valid());
         posts.reset(*session.journal->xacts.back());
         post = *posts++;
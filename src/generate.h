@@ -55,9 +55,15 @@ class generate_posts_iterator
   session_t&   session;
   unsigned int seed;
   std::size_t  quantity;
+  int          cost_percent;
   date_t       next_date;
   date_t       next_aux_date;
 
+  // When not empty, account names and commodity symbols are drawn from
+  // these fixed sets rather than made up anew for every posting.
+  std::vector<string> account_pool;
+  std::vector<string> commodity_pool;
+
   mt19937 rnd_gen;
 
   typedef variate_generator<mt19937&, uniform_int<> >  int_generator_t;
@@ -88,6 +94,8 @@ class generate_posts_iterator
 
   uniform_int<>   strlen_range;
   int_generator_t strlen_gen;
+  uniform_int<>   percent_range;
+  int_generator_t percent_gen;
 
   uniform_real<>   neg_number_range;
   real_generator_t neg_number_gen;
@@ -99,7 +107,10 @@ class generate_posts_iterator
 public:
   generate_posts_iterator(session_t&   _session,
                           unsigned int _seed         = 0,
-                          std::size_t  _quantity     = 100);
+                          std::size_t  _quantity     = 100,
+                          std::size_t  _accounts     = 0,
+                          std::size_t  _commodities  = 0,
+                          int          _cost_percent = -1);
 
   virtual ~generate_posts_iterator() throw() {
     TRACE_DTOR(generate_posts_iterator);
@@ -108,6 +119,7 @@ public:
   virtual void increment();
 
 protected:
+  const string& choose(const std::vector<string>& pool);
   void   generate_string(std::ostream& out, int len, bool only_alpha = false);
   bool   generate_account(std::ostream& out, bool no_virtual = false);
   void   generate_commodity(std::ostream& out, const string& exclude = "");
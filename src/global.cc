@@ -47,6 +47,7 @@ static bool args_only = false;
 std::string       _init_file;
 
 global_scope_t::global_scope_t(char ** envp)
+  : client_fd(-1), client_errors(NULL)
 {
   epoch = CURRENT_TIME();
 
@@ -171,12 +172,14 @@ void global_scope_t::report_error(const std::exception& err)
   std::cout.flush();            // first display anything that was pending
 
   if (caught_signal == NONE_CAUGHT) {
+    std::ostream& out(client_errors ? *client_errors : std::cerr);
+
     // Display any pending error context information
     string context = error_context();
     if (! context.empty())
-      std::cerr << context << std::endl;
+      out << context << std::endl;
 
-    std::cerr << _("Error: ") << err.what() << std::endl;
+    out << _("Error: ") << err.what() << std::endl;
   } else {
     caught_signal = NONE_CAUGHT;
   }
@@ -233,15 +236,19 @@ void global_scope_t::execute_command(strings_list args, bool at_repl)
 
   // Create the output stream (it might be a file, the console or a PAGER
   // subprocess) and invoke the report command.  The output stream is closed
-  // by the caller of this function.
+  // by the caller of this function.  A client of the server gets its output
+  // over its connection, unless it asked for a file.
 
-  report().output_stream
-    .initialize(report().HANDLED(output_) ?
-                optional<path>(path(report().HANDLER(output_).str())) :
-                optional<path>(),
-                report().HANDLED(pager_) ?
-                optional<path>(path(report().HANDLER(pager_).str())) :
-                optional<path>());
+  if (client_fd != -1 && ! report().HANDLED(output_))
+    report().output_stream.initialize(client_fd);
+  else
+    report().output_stream
+      .initialize(report().HANDLED(output_) ?
+                  optional<path>(path(report().HANDLER(output_).str())) :
+                  optional<path>(),
+                  report().HANDLED(pager_) && client_fd == -1 ?
+                  optional<path>(path(report().HANDLER(pager_).str())) :
+                  optional<path>());
 
   // Now that the output stream is initialized, report the options that will
   // participate in this report, if the user specified --options
@@ -284,6 +291,208 @@ int global_scope_t::execute_command_wrapper(strings_list args, bool at_repl)
   return status;
 }
 
+#if HAVE_UNIX_SOCKETS
+
+namespace {
+  /**
+   * @brief The socket a server listens on, closed and removed from the
+   * filesystem however serving comes to an end.
+   */
+  struct listener_t
+  {
+    string name;
+    string bound_name;          // where the socket now is, once bound
+    int    fd;
+
+    listener_t(const string& _name) : name(_name), fd(-1) {}
+    ~listener_t() {
+      if (fd != -1)
+        ::close(fd);
+      if (! bound_name.empty())
+        ::unlink(bound_name.c_str());
+    }
+  };
+
+  // A connection to an existing socket means another server is still
+  // answering there; otherwise the socket was left behind and may go.
+  bool socket_in_use(const sockaddr_un& addr)
+  {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+      return false;
+    bool in_use = ::connect(fd, reinterpret_cast<const sockaddr *>(&addr),
+                            sizeof(addr)) == 0;
+    ::close(fd);
+    return in_use;
+  }
+}
+
+value_t global_scope_t::server_command(call_scope_t&)
+{
+  listener_t listener(HANDLER(socket_).str());
+
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  if (listener.name.empty() ||
+      listener.name.length() >= sizeof(addr.sun_path))
+    throw_(std::logic_error,
+           _f("Invalid socket name '%1%'") % listener.name);
+  addr.sun_family = AF_UNIX;
+  std::strcpy(addr.sun_path, listener.name.c_str());
+
+  // The socket is bound and listening under a temporary name in the same
+  // directory, and only then renamed to the one given, since a client
+  // that finds the socket before listen() is called is refused.
+  string temp_name(listener.name + ".tmp" + lexical_cast<string>(::getpid()));
+  if (temp_name.length() >= sizeof(addr.sun_path))
+    throw_(std::logic_error,
+           _f("Invalid socket name '%1%'") % listener.name);
+  sockaddr_un temp_addr(addr);
+  std::strcpy(temp_addr.sun_path, temp_name.c_str());
+
+  struct stat info;
+  if (::lstat(addr.sun_path, &info) == 0) {
+    if (! S_ISSOCK(info.st_mode))
+      throw_(std::logic_error,
+             _f("File '%1%' exists and is not a socket") % listener.name);
+    if (socket_in_use(addr))
+      throw_(std::logic_error,
+             _f("Socket '%1%' is already in use") % listener.name);
+    ::unlink(addr.sun_path);
+  }
+
+  // Read the journal before listening, so that once the socket exists,
+  // every client is answered from data already in memory.
+  session().set_reloadable(true);
+  session().read_journal_files();
+
+  listener.fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener.fd == -1)
+    throw_(std::runtime_error,
+           _f("Failed to create socket: %1%") % std::strerror(errno));
+  if (::bind(listener.fd, reinterpret_cast<sockaddr *>(&temp_addr),
+             sizeof(temp_addr)) == -1)
+    throw_(std::runtime_error, _f("Failed to bind socket '%1%': %2%")
+           % temp_name % std::strerror(errno));
+  listener.bound_name = temp_name;
+  if (::listen(listener.fd, SOMAXCONN) == -1)
+    throw_(std::runtime_error, _f("Failed to listen on socket '%1%': %2%")
+           % temp_name % std::strerror(errno));
+  if (::rename(temp_name.c_str(), listener.name.c_str()) == -1)
+    throw_(std::runtime_error, _f("Failed to rename socket '%1%': %2%")
+           % temp_name % std::strerror(errno));
+  listener.bound_name = listener.name;
+
+  INFO("Serving journal on " << listener.name);
+
+  // Clients are answered one at a time, since every report shares the
+  // session's journal.  Serving ends on SIGINT, which interrupts poll.
+  while (caught_signal != INTERRUPTED) {
+    pollfd pending;
+    pending.fd      = listener.fd;
+    pending.events  = POLLIN;
+    pending.revents = 0;
+
+    int ready = ::poll(&pending, 1, -1);
+    if (ready == -1 && errno != EINTR)
+      throw_(std::runtime_error,
+             _f("Failed to wait for clients: %1%") % std::strerror(errno));
+    if (ready <= 0)
+      continue;
+
+    int fd = ::accept(listener.fd, NULL, NULL);
+    if (fd == -1)
+      continue;
+
+    serve_client(fd);
+    ::close(fd);
+
+    // A client that hung up early leaves SIGPIPE behind; that ended only
+    // its own report.
+    if (caught_signal == PIPE_CLOSED)
+      caught_signal = NONE_CAUGHT;
+  }
+  caught_signal = NONE_CAUGHT;
+
+  INFO("Stopped serving journal on " << listener.name);
+  return true;
+}
+
+void global_scope_t::serve_client(int fd)
+{
+  // Each connection carries a single command line.  Waiting for it, and
+  // for the client to take its report, is bounded so that a client which
+  // stops sending or reading cannot hold up those behind it; once a write
+  // times out, the rest of that report is dropped.
+  timeval timeout;
+  timeout.tv_sec  = 5;
+  timeout.tv_usec = 0;
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  string line;
+  char   buf[4096];
+  for (;;) {
+    ssize_t len = ::read(fd, buf, sizeof(buf));
+    if (len == -1 && errno == EINTR && caught_signal != INTERRUPTED)
+      continue;
+    if (len == -1)
+      return;                   // timed out, or the connection failed
+    if (len == 0)
+      break;                    // the client has finished sending
+    line.append(buf, static_cast<std::size_t>(len));
+    if (line.find('\n') != string::npos)
+      break;
+  }
+
+  string::size_type end = line.find_first_of("\r\n");
+  if (end != string::npos)
+    line.erase(end);
+  if (line.empty() || caught_signal == INTERRUPTED)
+    return;
+
+  DEBUG("global.server", "Client command: " << line);
+
+  string::size_type start = line.find_first_not_of(" \t");
+  if (start == string::npos || line[start] == '#')
+    return;
+
+  output_stream_t errors;
+  errors.initialize(fd);
+
+  client_fd     = fd;
+  client_errors = &static_cast<std::ostream&>(errors);
+
+  std::size_t depth = report_stack.size();
+  try {
+    execute_command_wrapper(split_arguments(line.c_str() + start), true);
+  }
+  catch (const error_count&) {
+    // Options such as --version end a command this way, which must end
+    // neither the server nor leave the command's report behind.
+    while (report_stack.size() > depth)
+      pop_report();
+  }
+
+  client_fd     = -1;
+  client_errors = NULL;
+}
+
+#else // HAVE_UNIX_SOCKETS
+
+value_t global_scope_t::server_command(call_scope_t&)
+{
+  throw_(std::logic_error,
+         _("Serving over a socket is not supported on this platform"));
+  return false;
+}
+
+void global_scope_t::serve_client(int)
+{
+}
+
+#endif // HAVE_UNIX_SOCKETS
+
 void global_scope_t::report_options(report_t& report, std::ostream& out)
 {
   out << "==============================================================================="
@@ -294,6 +503,7 @@ void global_scope_t::report_options(report_t& report, std::ostream& out)
   HANDLER(debug_).report(out);
   HANDLER(init_file_).report(out);
   HANDLER(script_).report(out);
+  HANDLER(socket_).report(out);
   HANDLER(trace_).report(out);
   HANDLER(verbose).report(out);
   HANDLER(verify).report(out);
@@ -328,6 +538,7 @@ option_t<global_scope_t> * global_scope_t::lookup_option(const char * p)
     break;
   case 's':
     OPT(script_);
+    else OPT(socket_);
     break;
   case 't':
     OPT(trace_);
@@ -357,6 +568,11 @@ expr_t::ptr_op_t global_scope_t::lookup(const symbol_t::kind_t kind,
     break;
 
   case symbol_t::PRECOMMAND: {
+    // A client of the server may neither change the report its successors
+    // start from, nor start a server of its own.
+    if (client_fd != -1)
+      break;
+
     const char * p = name.c_str();
     switch (*p) {
     case 'p':
@@ -365,6 +581,11 @@ expr_t::ptr_op_t global_scope_t::lookup(const symbol_t::kind_t kind,
       else if (is_eq(p, "pop"))
         return MAKE_FUNCTOR(global_scope_t::pop_command);
       break;
+    case 's':
+      // Without --socket, leave "server" to the Python module of that name.
+      if (is_eq(p, "server") && HANDLED(socket_))
+        return MAKE_FUNCTOR(global_scope_t::server_command);
+      break;
     }
   }
   default:
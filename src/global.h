@@ -54,6 +54,11 @@ class global_scope_t : public noncopyable, public scope_t
   ptr_list<report_t>    report_stack;
   empty_scope_t         empty_scope;
 
+  // While the server command is answering a client, report output and
+  // errors go to the client's connection rather than to the console.
+  int                   client_fd;
+  std::ostream *        client_errors;
+
 public:
   global_scope_t(char ** envp);
   ~global_scope_t();
@@ -119,6 +124,9 @@ public:
     return true;
   }
 
+  value_t server_command(call_scope_t&);
+  void    serve_client(int fd);
+
   void show_version_info(std::ostream& out) {
     out <<
       "Ledger " << Ledger_VERSION_MAJOR << '.' << Ledger_VERSION_MINOR << '.'
@@ -159,6 +167,7 @@ See LICENSE file included with the distribution for details and disclaimer.");
 
   OPTION(global_scope_t, options);
   OPTION(global_scope_t, script_);
+  OPTION(global_scope_t, socket_);
   OPTION(global_scope_t, trace_);
   OPTION(global_scope_t, verbose);
   OPTION(global_scope_t, verify);
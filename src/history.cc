@@ -32,6 +32,7 @@
 #include <system.hh>
 
 #include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/biconnected_components.hpp>
 #include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <boost/graph/graphviz.hpp>
@@ -54,6 +55,115 @@ namespace boost {
 
 namespace ledger {
 
+// The prices recorded on one edge of the price graph, kept in a vector
+// sorted by time rather than in a map, which costs a node per price.
+// Prices usually arrive in order and are simply appended; any that
+// arrive out of order wait in a second vector, and are merged in the
+// next time the prices are looked at.  A later price for the same moment
+// replaces an earlier one, as it would in a map.
+class price_series_t
+{
+public:
+  typedef std::pair<datetime_t, amount_t>   value_type;
+  typedef std::vector<value_type>           series_t;
+  typedef series_t::const_iterator          const_iterator;
+  typedef const_iterator                    iterator;
+
+private:
+  mutable series_t prices;
+  mutable series_t pending;
+
+  struct earlier_than {
+    bool operator()(const value_type& a, const value_type& b) const {
+      return a.first < b.first;
+    }
+    bool operator()(const value_type& a, const datetime_t& when) const {
+      return a.first < when;
+    }
+    bool operator()(const datetime_t& when, const value_type& b) const {
+      return when < b.first;
+    }
+  };
+
+  void settle() const;
+
+public:
+  bool empty() const {
+    return prices.empty() && pending.empty();
+  }
+  std::size_t size() const {
+    settle();
+    return prices.size();
+  }
+
+  const_iterator begin() const {
+    settle();
+    return prices.begin();
+  }
+  const_iterator end() const {
+    settle();
+    return prices.end();
+  }
+
+  // The first price after WHEN, as with std::map::upper_bound.
+  const_iterator upper_bound(const datetime_t& when) const {
+    settle();
+    return std::upper_bound(prices.begin(), prices.end(), when,
+                            earlier_than());
+  }
+
+  void insert(const datetime_t& when, const amount_t& price) {
+    if (pending.empty() && (prices.empty() || prices.back().first <= when)) {
+      if (! prices.empty() && prices.back().first == when)
+        prices.back().second = price;
+      else
+        prices.push_back(value_type(when, price));
+    } else {
+      pending.push_back(value_type(when, price));
+    }
+  }
+
+  bool erase(const datetime_t& when) {
+    settle();
+    series_t::iterator i =
+      std::lower_bound(prices.begin(), prices.end(), when, earlier_than());
+    if (i == prices.end() || (*i).first != when)
+      return false;
+    prices.erase(i);
+    return true;
+  }
+};
+
+void price_series_t::settle() const
+{
+  if (pending.empty())
+    return;
+
+  // Both vectors are in order of arrival within each moment, and a stable
+  // merge keeps it so; only the last price of each moment is then kept.
+  std::stable_sort(pending.begin(), pending.end(), earlier_than());
+
+  series_t merged;
+  merged.reserve(prices.size() + pending.size());
+  std::merge(prices.begin(), prices.end(), pending.begin(), pending.end(),
+             std::back_inserter(merged), earlier_than());
+
+  series_t::iterator out = merged.begin();
+  for (series_t::iterator i = merged.begin(); i != merged.end(); ++i) {
+    if (out != merged.begin() && (*(out - 1)).first == (*i).first)
+      *(out - 1) = *i;
+    else
+      *out++ = *i;
+  }
+  merged.erase(out, merged.end());
+
+  prices.swap(merged);
+  pending.clear();
+
+  DEBUG("history.prices", "Merged late prices; edge now has "
+        << prices.size() << " prices");
+}
+
 class commodity_history_impl_t : public noncopyable
 {
 public:
@@ -71,7 +181,7 @@ public:
     // filtered_graph is used to select the recent price point to the
     // reference time before performing the search.
     property<edge_weight_t, long,
-             property<edge_price_ratio_t, price_map_t,
+             property<edge_price_ratio_t, price_series_t,
                       property<edge_price_point_t, price_point_t> > >,
 
     // Graph itself has a std::string name
@@ -91,9 +201,33 @@ public:
   PricePointMap pricemap;
   PriceRatioMap ratiomap;
 
+  // An index of the graph's bridges, the edges that lie on no cycle.
+  // Between two commodities joined by bridges alone there is only one
+  // path, so find_price can follow it instead of searching the graph.
+  // The bridges form a forest, kept here as each vertex's parent, the
+  // edge to it, its depth and the root of its tree.  The index depends
+  // only on which commodities have prices between them, so it is rebuilt
+  // when an edge is added or removed, not when a price is.
+  std::size_t                    generation;
+  bool                           use_index;
+  bool                           index_valid;
+  std::vector<vertex_descriptor> index_root;
+  std::vector<vertex_descriptor> index_parent;
+  std::vector<edge_descriptor>   index_edge;
+  std::vector<std::size_t>       index_depth;
+
   commodity_history_impl_t()
     : pricemap(get(edge_price_point, price_graph)),
-      ratiomap(get(edge_price_ratio, price_graph)) {}
+      ratiomap(get(edge_price_ratio, price_graph)),
+      generation(0), use_index(true), index_valid(false) {}
+
+  void build_index();
+
+  optional<price_point_t>
+  find_price_along_bridges(vertex_descriptor  sv,
+                           vertex_descriptor  tv,
+                           const datetime_t&  moment,
+                           const datetime_t&  oldest);
 
   void add_commodity(commodity_t& comm);
 
@@ -110,6 +244,10 @@ public:
                   const datetime_t&  _oldest = datetime_t(),
                   bool bidirectionally = false);
 
+  void map_all_prices(function<void(const commodity_t& source,
+                                    const datetime_t&  when,
+                                    const amount_t&    price)> fn);
+
   optional<price_point_t>
   find_price(const commodity_t& source,
              const datetime_t&  moment,
@@ -133,6 +271,11 @@ commodity_history_t::~commodity_history_t()
 {
 }
 
+void commodity_history_t::use_index(bool enabled)
+{
+  p_impl->use_index = enabled;
+}
+
 void commodity_history_t::add_commodity(commodity_t& comm)
 {
   p_impl->add_commodity(comm);
@@ -152,6 +295,11 @@ void commodity_history_t::remove_price(const commodity_t& source,
   p_impl->remove_price(source, target, date);
 }
 
+std::size_t commodity_history_t::generation() const
+{
+  return p_impl->generation;
+}
+
 void commodity_history_t::map_prices(
   function<void(datetime_t, const amount_t&)> fn,
   const commodity_t& source,
@@ -162,6 +310,14 @@ void commodity_history_t::map_prices(
   p_impl->map_prices(fn, source, moment, _oldest, bidirectionally);
 }
 
+void commodity_history_t::map_all_prices(
+  function<void(const commodity_t& source,
+                const datetime_t&  when,
+                const amount_t&    price)> fn)
+{
+  p_impl->map_all_prices(fn);
+}
+
 optional<price_point_t>
 commodity_history_t::find_price(const commodity_t& source,
                                 const datetime_t&  moment,
@@ -217,13 +373,13 @@ public:
     }
 #endif
 
-    const price_map_t& prices(get(ratios, e));
+    const price_series_t& prices(get(ratios, e));
     if (prices.empty()) {
       DEBUG("history.find", "  prices map is empty for this edge");
       return false;
     }
 
-    price_map_t::const_iterator low = prices.upper_bound(reftime);
+    price_series_t::const_iterator low = prices.upper_bound(reftime);
     if (low != prices.end() && low == prices.begin()) {
       DEBUG("history.find", "  don't use this edge");
       return false;
@@ -267,7 +423,16 @@ void commodity_history_impl_t::add_commodity(commodity_t& comm)
 {
   if (! comm.graph_index()) {
     comm.set_graph_index(num_vertices(price_graph));
-    add_vertex(/* vertex_name= */ &comm, price_graph);
+    vertex_descriptor v = add_vertex(/* vertex_name= */ &comm, price_graph);
+
+    // A commodity with no prices yet is a tree of its own, so there is no
+    // need to rebuild the index.
+    if (index_valid) {
+      index_root.push_back(v);
+      index_parent.push_back(v);
+      index_edge.push_back(edge_descriptor());
+      index_depth.push_back(0);
+    }
   }
 }
 
@@ -281,17 +446,14 @@ void commodity_history_impl_t::add_price(const commodity_t& source,
   vertex_descriptor tv = vertex(*price.commodity().graph_index(), price_graph);
 
   std::pair<edge_descriptor, bool> e1 = edge(sv, tv, price_graph);
-  if (! e1.second)
+  if (! e1.second) {
     e1 = add_edge(sv, tv, price_graph);
-
-  price_map_t& prices(get(ratiomap, e1.first));
-
-  std::pair<price_map_t::iterator, bool> result =
-    prices.insert(price_map_t::value_type(when, price));
-  if (! result.second) {
-    // There is already an entry for this moment, so update it
-    (*result.first).second = price;
+    index_valid = false;
   }
+
+  // If there is already an entry for this moment, it is updated
+  get(ratiomap, e1.first).insert(when, price);
+  generation++;
 }
 
 void commodity_history_impl_t::remove_price(const commodity_t& source,
@@ -305,13 +467,16 @@ void commodity_history_impl_t::remove_price(const commodity_t& source,
 
   std::pair<Graph::edge_descriptor, bool> e1 = edge(sv, tv, price_graph);
   if (e1.second) {
-    price_map_t& prices(get(ratiomap, e1.first));
+    price_series_t& prices(get(ratiomap, e1.first));
 
     // jww (2012-03-04): If it fails, should we give a warning?
-    prices.erase(date);
+    if (prices.erase(date))
+      generation++;
 
-    if (prices.empty())
+    if (prices.empty()) {
       remove_edge(e1.first, price_graph);
+      index_valid = false;
+    }
   }
 }
 
@@ -338,9 +503,9 @@ void commodity_history_impl_t::map_prices(
     std::pair<Graph::edge_descriptor, bool> edgePair = edge(sv, *f_vi, fg);
     Graph::edge_descriptor edge = edgePair.first;
 
-    const price_map_t& prices(get(ratiomap, edge));
+    const price_series_t& prices(get(ratiomap, edge));
 
-    foreach (const price_map_t::value_type& pair, prices) {
+    foreach (const price_series_t::value_type& pair, prices) {
       const datetime_t& when(pair.first);
 
       DEBUG("history.map", "Price " << pair.second << " on " << when);
@@ -367,6 +532,31 @@ void commodity_history_impl_t::map_prices(
   }
 }
 
+void commodity_history_impl_t::map_all_prices(
+  function<void(const commodity_t& source,
+                const datetime_t&  when,
+                const amount_t&    price)> fn)
+{
+  NameMap namemap(get(vertex_name, price_graph));
+
+  // Edges are visited in the order they were created, so that calling
+  // add_price on each price in turn recreates the same graph.
+  graph_traits<Graph>::edge_iterator ei, eend;
+  for (boost::tuples::tie(ei, eend) = edges(price_graph); ei != eend; ++ei) {
+    const commodity_t * first  = get(namemap, boost::source(*ei, price_graph));
+    const commodity_t * second = get(namemap, boost::target(*ei, price_graph));
+
+    foreach (const price_series_t::value_type& pair, get(ratiomap, *ei)) {
+      // Edges are undirected, so the source of each price is whichever
+      // commodity the price is not expressed in.
+      if (pair.second.commodity().graph_index() == first->graph_index())
+        fn(*second, pair.first, pair.second);
+      else
+        fn(*first, pair.first, pair.second);
+    }
+  }
+}
+
 optional<price_point_t>
 commodity_history_impl_t::find_price(const commodity_t& source,
                                      const datetime_t&  moment,
@@ -428,6 +618,76 @@ commodity_history_impl_t::find_price(const commodity_t& source,
   }
 }
 
+namespace {
+  // Once the target has been taken from the queue, its path can no longer
+  // change, so there is no need to search the rest of the graph.
+  class stop_at_target : public default_dijkstra_visitor
+  {
+    commodity_history_impl_t::vertex_descriptor target;
+
+  public:
+    struct reached {};
+
+    stop_at_target(commodity_history_impl_t::vertex_descriptor _target)
+      : target(_target) {}
+
+    template <typename Vertex, typename Graph>
+    void examine_vertex(Vertex u, const Graph&) {
+      if (u == target)
+        throw reached();
+    }
+  };
+
+  // Fold the price POINT, on the edge between U_COMM and V_COMM, into the
+  // conversion PRICE found so far on a path walked back from the target.
+  void accumulate_price(amount_t&            price,
+                        datetime_t&          least_recent,
+                        const commodity_t *& last_target,
+                        const commodity_t *  u_comm,
+                        const commodity_t *  v_comm,
+                        const price_point_t& point)
+  {
+    bool first_run = false;
+    if (price.is_null()) {
+      least_recent = point.when;
+      first_run    = true;
+    }
+    else if (point.when < least_recent) {
+      least_recent = point.when;
+    }
+
+    DEBUG("history.find", "u commodity = " << u_comm->symbol());
+    DEBUG("history.find", "v commodity = " << v_comm->symbol());
+    DEBUG("history.find", "last target = " << last_target->symbol());
+
+    // Determine which direction we are converting in
+    amount_t pprice(point.price);
+    DEBUG("history.find", "pprice    = " << pprice.unrounded());
+
+    if (! first_run) {
+      DEBUG("history.find", "price was = " << price.unrounded());
+      if (pprice.commodity_ptr() != last_target)
+        price *= pprice.inverted();
+      else
+        price *= pprice;
+    }
+    else if (pprice.commodity_ptr() != last_target) {
+      price = pprice.inverted();
+    }
+    else {
+      price = pprice;
+    }
+    DEBUG("history.find", "price is  = " << price.unrounded());
+
+    if (last_target == v_comm)
+      last_target = u_comm;
+    else
+      last_target = v_comm;
+
+    DEBUG("history.find", "last target now = " << last_target->symbol());
+  }
+}
+
 optional<price_point_t>
 commodity_history_impl_t::find_price(const commodity_t& source,
                                      const commodity_t& target,
@@ -439,6 +699,13 @@ commodity_history_impl_t::find_price(const commodity_t& source,
   vertex_descriptor sv = vertex(*source.graph_index(), price_graph);
   vertex_descriptor tv = vertex(*target.graph_index(), price_graph);
 
+  if (use_index) {
+    if (! index_valid)
+      build_index();
+    if (index_root[sv] == index_root[tv])
+      return find_price_along_bridges(sv, tv, moment, oldest);
+  }
+
   FGraph fg(price_graph,
             recent_edge_weight<EdgeWeightMap, PricePointMap, PriceRatioMap>
             (get(edge_weight, price_graph), pricemap, ratiomap,
@@ -456,10 +723,14 @@ commodity_history_impl_t::find_price(const commodity_t& source,
   FPredecessorMap predecessorMap(&predecessors[0]);
   FDistanceMap    distanceMap(&distances[0]);
 
-  dijkstra_shortest_paths(fg, /* start= */ sv,
-                          predecessor_map(predecessorMap)
-                          .distance_map(distanceMap)
-                          .distance_combine(f_max<long>()));
+  try {
+    dijkstra_shortest_paths(fg, /* start= */ sv,
+                            predecessor_map(predecessorMap)
+                            .distance_map(distanceMap)
+                            .distance_combine(f_max<long>())
+                            .visitor(stop_at_target(tv)));
+  }
+  catch (const stop_at_target::reached&) {}
 
   // Extract the shortest path and performance the calculations
   datetime_t least_recent = moment;
@@ -512,44 +783,7 @@ commodity_history_impl_t::find_price(const commodity_t& source,
     assert(u_comm == last_target || v_comm == last_target);
 #endif
 
-    bool first_run = false;
-    if (price.is_null()) {
-      least_recent = point.when;
-      first_run    = true;
-    }
-    else if (point.when < least_recent) {
-      least_recent = point.when;
-    }
-
-    DEBUG("history.find", "u commodity = " << u_comm->symbol());
-    DEBUG("history.find", "v commodity = " << v_comm->symbol());
-    DEBUG("history.find", "last target = " << last_target->symbol());
-
-    // Determine which direction we are converting in
-    amount_t pprice(point.price);
-    DEBUG("history.find", "pprice    = " << pprice.unrounded());
-
-    if (! first_run) {
-      DEBUG("history.find", "price was = " << price.unrounded());
-      if (pprice.commodity_ptr() != last_target)
-        price *= pprice.inverted();
-      else
-        price *= pprice;
-    }
-    else if (pprice.commodity_ptr() != last_target) {
-      price = pprice.inverted();
-    }
-    else {
-      price = pprice;
-    }
-    DEBUG("history.find", "price is  = " << price.unrounded());
-
-    if (last_target == v_comm)
-      last_target = u_comm;
-    else
-      last_target = v_comm;
-
-    DEBUG("history.find", "last target now = " << last_target->symbol());
+    accumulate_price(price, least_recent, last_target, u_comm, v_comm, point);
   }
 
   if (price.is_null()) {
@@ -563,6 +797,135 @@ commodity_history_impl_t::find_price(const commodity_t& source,
   }
 }
 
+void commodity_history_impl_t::build_index()
+{
+  typedef std::map<edge_descriptor, std::size_t> component_map_t;
+
+  // Number the graph's biconnected components; those made of a single
+  // edge are its bridges.
+  component_map_t components;
+  std::size_t     num_components =
+    biconnected_components(price_graph,
+                           associative_property_map<component_map_t>
+                           (components));
+
+  std::vector<std::size_t> component_size(num_components, 0);
+  foreach (const component_map_t::value_type& pair, components)
+    component_size[pair.second]++;
+
+  const vertex_descriptor none_yet = graph_traits<Graph>::null_vertex();
+  std::size_t             count    = num_vertices(price_graph);
+
+  index_root.assign(count, none_yet);
+  index_parent.assign(count, none_yet);
+  index_edge.assign(count, edge_descriptor());
+  index_depth.assign(count, 0);
+
+  // Grow a tree over the bridges, breadth first, from each vertex not yet
+  // reached.
+  std::vector<vertex_descriptor> pending;
+  for (vertex_descriptor root = 0; root < count; root++) {
+    if (index_root[root] != none_yet)
+      continue;
+
+    index_root[root]   = root;
+    index_parent[root] = root;
+    pending.assign(1, root);
+
+    for (std::size_t next = 0; next < pending.size(); next++) {
+      vertex_descriptor u = pending[next];
+
+      graph_traits<Graph>::out_edge_iterator ei, eend;
+      for (boost::tuples::tie(ei, eend) = out_edges(u, price_graph);
+           ei != eend; ++ei) {
+        if (component_size[components[*ei]] != 1)
+          continue;
+
+        vertex_descriptor v = boost::target(*ei, price_graph);
+        if (index_root[v] != none_yet)
+          continue;
+
+        index_root[v]   = root;
+        index_parent[v] = u;
+        index_edge[v]   = *ei;
+        index_depth[v]  = index_depth[u] + 1;
+        pending.push_back(v);
+      }
+    }
+  }
+
+  DEBUG("history.index", "Indexed " << count << " commodities, "
+        << num_components << " biconnected components");
+
+  index_valid = true;
+}
+
+optional<price_point_t>
+commodity_history_impl_t::find_price_along_bridges(vertex_descriptor sv,
+                                                   vertex_descriptor tv,
+                                                   const datetime_t& moment,
+                                                   const datetime_t& oldest)
+{
+  // Walk up from both ends to where their paths meet.  The edges are
+  // then visited as the search in find_price would: from the target up
+  // to the meeting point, and from there down to the source.  Each is
+  // named by the vertex below it.
+  std::vector<vertex_descriptor> from_target;
+  std::vector<vertex_descriptor> from_source;
+
+  vertex_descriptor t = tv;
+  vertex_descriptor s = sv;
+  while (index_depth[t] > index_depth[s]) {
+    from_target.push_back(t);
+    t = index_parent[t];
+  }
+  while (index_depth[s] > index_depth[t]) {
+    from_source.push_back(s);
+    s = index_parent[s];
+  }
+  while (s != t) {
+    from_target.push_back(t);
+    t = index_parent[t];
+    from_source.push_back(s);
+    s = index_parent[s];
+  }
+  from_target.insert(from_target.end(),
+                     from_source.rbegin(), from_source.rend());
+
+  NameMap namemap(get(vertex_name, price_graph));
+
+  datetime_t least_recent = moment;
+  amount_t   price;
+
+  const commodity_t * last_target = get(namemap, tv);
+
+  foreach (vertex_descriptor below, from_target) {
+    const price_series_t& prices(get(ratiomap, index_edge[below]));
+
+    // Use the most recent price as of MOMENT, as recent_edge_weight
+    // would; without one there is no path.
+    price_series_t::const_iterator low = prices.upper_bound(moment);
+    if (low == prices.begin()) {
+      DEBUG("history.find", "no price on the path as of " << moment);
+      return none;
+    }
+    --low;
+    if (! oldest.is_not_a_date_time() && (*low).first < oldest) {
+      DEBUG("history.find", "price on the path is out of range");
+      return none;
+    }
+
+    accumulate_price(price, least_recent, last_target,
+                     get(namemap, index_parent[below]), get(namemap, below),
+                     price_point_t((*low).first, (*low).second));
+  }
+
+  price.set_commodity(const_cast<commodity_t&>(*get(namemap, tv)));
+  DEBUG("history.find", "final price is = " << price.unrounded());
+
+  return price_point_t(least_recent, price);
+}
+
 template <class Name>
 class label_writer {
 public:
@@ -61,6 +61,11 @@ class commodity_history_t : public noncopyable
 public:
   commodity_history_t();
 
+  // Whether find_price may follow a precomputed path between commodities
+  // that have only one, rather than search the price graph (see
+  // --no-price-index).
+  void use_index(bool enabled);
+
   void add_commodity(commodity_t& comm);
 
   void add_price(const commodity_t& source,
@@ -70,12 +75,20 @@ public:
                     const commodity_t& target,
                     const datetime_t&  date);
 
+  // A count of the prices added or removed so far, so that answers
+  // remembered from an earlier search can be seen to be out of date.
+  std::size_t generation() const;
+
   void map_prices(function<void(datetime_t, const amount_t&)> fn,
                   const commodity_t& source,
                   const datetime_t&  moment,
                   const datetime_t&  _oldest = datetime_t(),
                   bool bidirectionally = false);
 
+  void map_all_prices(function<void(const commodity_t& source,
+                                    const datetime_t&  when,
+                                    const amount_t&    price)> fn);
+
   boost::optional<price_point_t>
   find_price(const commodity_t& source,
              const datetime_t&  moment,
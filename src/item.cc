@@ -37,6 +37,64 @@ namespace ledger {
 
 bool item_t::use_aux_date = false;
 
+tag_names_t * tag_names_t::current = NULL;
+
+std::size_t tag_names_t::key_hash::operator()(const string& name) const
+{
+  std::size_t hash = 0;
+  foreach (char ch, name)
+    hash = hash * 31 + static_cast<std::size_t>
+      (std::toupper(static_cast<unsigned char>(ch)));
+  return hash;
+}
+
+bool tag_names_t::key_equal::operator()(const string& left,
+                                        const string& right) const
+{
+  if (left.length() != right.length())
+    return false;
+  for (std::size_t i = 0; i < left.length(); i++)
+    if (std::toupper(static_cast<unsigned char>(left[i])) !=
+        std::toupper(static_cast<unsigned char>(right[i])))
+      return false;
+  return true;
+}
+
+tag_name_t tag_names_t::intern(const string& name)
+{
+  std::unordered_map<string, const tag_name_t::entry_t *>::const_iterator
+    i = ids.find(name);
+  if (i != ids.end())
+    return tag_name_t((*i).second);
+
+  // A new key is the number of the first spelling to use it.
+  uint32_t next_key = static_cast<uint32_t>(names.size());
+  std::pair<std::unordered_map<string, uint32_t, key_hash, key_equal>::iterator,
+            bool> result = keys.insert(std::make_pair(name, next_key));
+  names.push_back(tag_name_t::entry_t(name, (*result.first).second));
+  ids.insert(std::make_pair(name, &names.back()));
+  return tag_name_t(&names.back());
+}
+
+std::pair<tag_map_t::iterator, bool>
+tag_map_t::insert(const string& tag, const data_type& data)
+{
+  tag_name_t name(names->intern(tag));
+
+  iterator i = find_key(name.key());
+  if (i != tags.end())
+    return std::pair<iterator, bool>(i, false);
+
+  // Keep the tags in the order a case-insensitive map of names would
+  // list them, which is the order in which they are printed.
+  for (i = tags.begin(); i != tags.end(); i++)
+    if (boost::algorithm::ilexicographical_compare(tag, (*i).first.str()))
+      break;
+
+  return std::pair<iterator, bool>(tags.insert(i, value_type(name, data)),
+                                   true);
+}
+
 bool item_t::has_tag(const string& tag, bool) const
 {
   DEBUG("item.meta", "Checking if item has tag: " << tag);
@@ -44,7 +102,7 @@ bool item_t::has_tag(const string& tag, bool) const
     DEBUG("item.meta", "Item has no metadata at all");
     return false;
   }
-  string_map::const_iterator i = metadata->find(tag);
+  tag_map_t::const_iterator i = metadata->find(tag);
 #if DEBUG_ON
   if (SHOW_DEBUG("item.meta")) {
     if (i == metadata->end())
@@ -60,7 +118,7 @@ bool item_t::has_tag(const mask_t& tag_mask,
                      const optional<mask_t>& value_mask, bool) const
 {
   if (metadata) {
-    foreach (const string_map::value_type& data, *metadata) {
+    foreach (const tag_map_t::value_type& data, *metadata) {
       if (tag_mask.match(data.first)) {
         if (! value_mask)
           return true;
@@ -77,7 +135,7 @@ optional<value_t> item_t::get_tag(const string& tag, bool) const
   DEBUG("item.meta", "Getting item tag: " << tag);
   if (metadata) {
     DEBUG("item.meta", "Item has metadata");
-    string_map::const_iterator i = metadata->find(tag);
+    tag_map_t::const_iterator i = metadata->find(tag);
     if (i != metadata->end()) {
       DEBUG("item.meta", "Found the item!");
       return (*i).second.first;
@@ -91,7 +149,7 @@ optional<value_t> item_t::get_tag(const mask_t& tag_mask,
                                   bool) const
 {
   if (metadata) {
-    foreach (const string_map::value_type& data, *metadata) {
+    foreach (const tag_map_t::value_type& data, *metadata) {
       if (tag_mask.match(data.first) &&
           (! value_mask ||
            (data.second.first &&
@@ -103,25 +161,17 @@ optional<value_t> item_t::get_tag(const mask_t& tag_mask,
   return none;
 }
 
-namespace {
-  struct CaseInsensitiveKeyCompare
-    : public std::binary_function<string, string, bool>
-  {
-    bool operator()(const string& s1, const string& s2) const {
-      return boost::algorithm::ilexicographical_compare(s1, s2);
-    }
-  };
-}
-
-item_t::string_map::iterator
+tag_map_t::iterator
 item_t::set_tag(const string&            tag,
                 const optional<value_t>& value,
                 const bool               overwrite_existing)
 {
   assert(! tag.empty());
 
-  if (! metadata)
-    metadata = string_map(CaseInsensitiveKeyCompare());
+  if (! metadata) {
+    assert(tag_names_t::current);
+    metadata = tag_map_t(*tag_names_t::current);
+  }
 
   DEBUG("item.meta", "Setting tag '" << tag << "' to value '"
         << (value ? *value : string_value("<none>")) << "'");
@@ -131,17 +181,11 @@ item_t::set_tag(const string&            tag,
                (data->is_string() && data->as_string().empty())))
     data = none;
 
-  string_map::iterator i = metadata->find(tag);
-  if (i == metadata->end()) {
-    std::pair<string_map::iterator, bool> result
-      = metadata->insert(string_map::value_type(tag, tag_data_t(data, false)));
-    assert(result.second);
-    return result.first;
-  } else {
-    if (overwrite_existing)
-      (*i).second = tag_data_t(data, false);
-    return i;
-  }
+  std::pair<tag_map_t::iterator, bool> result
+    = metadata->insert(tag, tag_data_t(data, false));
+  if (! result.second && overwrite_existing)
+    (*result.first).second = tag_data_t(data, false);
+  return result.first;
 }
 
 void item_t::parse_tags(const char * p,
@@ -185,7 +229,7 @@ void item_t::parse_tags(const char * p,
       for (char * r = std::strtok(q + 1, ":");
            r;
            r = std::strtok(NULL, ":")) {
-        string_map::iterator i = set_tag(r, none, overwrite_existing);
+        tag_map_t::iterator i = set_tag(r, none, overwrite_existing);
         (*i).second.second = true;
       }
     }
@@ -197,7 +241,7 @@ void item_t::parse_tags(const char * p,
       }
       tag = string(q, len - index);
 
-      string_map::iterator i;
+      tag_map_t::iterator i;
       string field(p + len + index);
       trim(field);
       if (by_value) {
@@ -381,8 +425,8 @@ namespace {
   }
 
   template <value_t (*Func)(item_t&)>
-  value_t get_wrapper(call_scope_t& scope) {
-    return (*Func)(find_scope<item_t>(scope));
+  scope_accessor_t<item_t> get_wrapper() {
+    return scope_accessor_t<item_t>(Func);
   }
 }
 
@@ -429,52 +473,52 @@ expr_t::ptr_op_t item_t::lookup(const symbol_t::kind_t kind,
   switch (name[0]) {
   case 'a':
     if (name == "actual")
-      return WRAP_FUNCTOR(get_wrapper<&get_actual>);
+      return WRAP_FUNCTOR(get_wrapper<&get_actual>());
     else if (name == "actual_date")
-      return WRAP_FUNCTOR(get_wrapper<&get_primary_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_primary_date>());
     else if (name == "addr")
-      return WRAP_FUNCTOR(get_wrapper<&get_addr>);
+      return WRAP_FUNCTOR(get_wrapper<&get_addr>());
     else if (name == "aux_date")
-      return WRAP_FUNCTOR(get_wrapper<&get_aux_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_aux_date>());
     break;
 
   case 'b':
     if (name == "beg_line")
-      return WRAP_FUNCTOR(get_wrapper<&get_beg_line>);
+      return WRAP_FUNCTOR(get_wrapper<&get_beg_line>());
     else if (name == "beg_pos")
-      return WRAP_FUNCTOR(get_wrapper<&get_beg_pos>);
+      return WRAP_FUNCTOR(get_wrapper<&get_beg_pos>());
     break;
 
   case 'c':
     if (name == "cleared")
-      return WRAP_FUNCTOR(get_wrapper<&get_cleared>);
+      return WRAP_FUNCTOR(get_wrapper<&get_cleared>());
     else if (name == "comment")
-      return WRAP_FUNCTOR(get_wrapper<&get_comment>);
+      return WRAP_FUNCTOR(get_wrapper<&get_comment>());
     break;
 
   case 'd':
     if (name[1] == '\0' || name == "date")
-      return WRAP_FUNCTOR(get_wrapper<&get_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_date>());
     else if (name == "depth")
-      return WRAP_FUNCTOR(get_wrapper<&get_depth>);
+      return WRAP_FUNCTOR(get_wrapper<&get_depth>());
     break;
 
   case 'e':
     if (name == "end_line")
-      return WRAP_FUNCTOR(get_wrapper<&get_end_line>);
+      return WRAP_FUNCTOR(get_wrapper<&get_end_line>());
     else if (name == "end_pos")
-      return WRAP_FUNCTOR(get_wrapper<&get_end_pos>);
+      return WRAP_FUNCTOR(get_wrapper<&get_end_pos>());
     else if (name == "effective_date")
-      return WRAP_FUNCTOR(get_wrapper<&get_aux_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_aux_date>());
     break;
 
   case 'f':
     if (name == "filename")
-      return WRAP_FUNCTOR(get_wrapper<&get_pathname>);
+      return WRAP_FUNCTOR(get_wrapper<&get_pathname>());
     else if (name == "filebase")
-      return WRAP_FUNCTOR(get_wrapper<&get_filebase>);
+      return WRAP_FUNCTOR(get_wrapper<&get_filebase>());
     else if (name == "filepath")
-      return WRAP_FUNCTOR(get_wrapper<&get_filepath>);
+      return WRAP_FUNCTOR(get_wrapper<&get_filepath>());
      break;
 
   case 'h':
@@ -486,9 +530,9 @@ expr_t::ptr_op_t item_t::lookup(const symbol_t::kind_t kind,
 
   case 'i':
     if (name == "is_account")
-      return WRAP_FUNCTOR(get_wrapper<&ignore>);
+      return WRAP_FUNCTOR(get_wrapper<&ignore>());
     else if (name == "id")
-      return WRAP_FUNCTOR(get_wrapper<&get_id>);
+      return WRAP_FUNCTOR(get_wrapper<&get_id>());
     break;
 
   case 'm':
@@ -498,23 +542,23 @@ expr_t::ptr_op_t item_t::lookup(const symbol_t::kind_t kind,
 
   case 'n':
     if (name == "note")
-      return WRAP_FUNCTOR(get_wrapper<&get_note>);
+      return WRAP_FUNCTOR(get_wrapper<&get_note>());
     break;
 
   case 'p':
     if (name == "pending")
-      return WRAP_FUNCTOR(get_wrapper<&get_pending>);
+      return WRAP_FUNCTOR(get_wrapper<&get_pending>());
     else if (name == "parent")
-      return WRAP_FUNCTOR(get_wrapper<&ignore>);
+      return WRAP_FUNCTOR(get_wrapper<&ignore>());
     else if (name == "primary_date")
-      return WRAP_FUNCTOR(get_wrapper<&get_primary_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_primary_date>());
     break;
 
   case 's':
     if (name == "status" || name == "state")
-      return WRAP_FUNCTOR(get_wrapper<&get_status>);
+      return WRAP_FUNCTOR(get_wrapper<&get_status>());
     else if (name == "seq")
-      return WRAP_FUNCTOR(get_wrapper<&get_seq>);
+      return WRAP_FUNCTOR(get_wrapper<&get_seq>());
     break;
 
   case 't':
@@ -524,29 +568,29 @@ expr_t::ptr_op_t item_t::lookup(const symbol_t::kind_t kind,
 
   case 'u':
     if (name == "uncleared")
-      return WRAP_FUNCTOR(get_wrapper<&get_uncleared>);
+      return WRAP_FUNCTOR(get_wrapper<&get_uncleared>());
     else if (name == "uuid")
-      return WRAP_FUNCTOR(get_wrapper<&get_id>);
+      return WRAP_FUNCTOR(get_wrapper<&get_id>());
     break;
 
   case 'v':
     if (name == "value_date")
-      return WRAP_FUNCTOR(get_wrapper<&get_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_date>());
     break;
 
   case 'L':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_actual>);
+      return WRAP_FUNCTOR(get_wrapper<&get_actual>());
     break;
 
   case 'X':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_cleared>);
+      return WRAP_FUNCTOR(get_wrapper<&get_cleared>());
     break;
 
   case 'Y':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_pending>);
+      return WRAP_FUNCTOR(get_wrapper<&get_pending>());
     break;
   }
 
@@ -600,15 +644,15 @@ string item_context(const item_t& item, const string& desc)
   return out.str();
 }
 
-void put_metadata(property_tree::ptree& st, const item_t::string_map& metadata)
+void put_metadata(property_tree::ptree& st, const tag_map_t& metadata)
 {
-  foreach (const item_t::string_map::value_type& pair, metadata) {
+  foreach (const tag_map_t::value_type& pair, metadata) {
     if (pair.second.first) {
       property_tree::ptree& vt(st.add("value", ""));
-      vt.put("<xmlattr>.key", pair.first);
+      vt.put("<xmlattr>.key", pair.first.str());
       put_value(vt, *pair.second.first);
     } else {
-      st.add("tag", pair.first);
+      st.add("tag", pair.first.str());
     }
   }
 }
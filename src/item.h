@@ -43,6 +43,7 @@
 #define _ITEM_H
 
 #include "scope.h"
+#include "arena.h"
 
 namespace ledger {
 
@@ -80,7 +81,145 @@ struct position_t
   }
 };
 
-class item_t : public supports_flags<uint_least16_t>, public scope_t
+/**
+ * A tag name as given to an item, which refers to its entry in the
+ * journal's tag_names_t.  Names are compared without regard to case:
+ * every spelling gets its own entry, so that items print their tags as
+ * written, but all spellings of a name share one key, which is what
+ * lookups compare.
+ */
+class tag_name_t
+{
+public:
+  typedef std::pair<string, uint32_t> entry_t; // spelling and key
+
+private:
+  const entry_t * entry;
+
+public:
+  static const uint32_t no_key = static_cast<uint32_t>(-1);
+
+  explicit tag_name_t(const entry_t * _entry) : entry(_entry) {}
+
+  const string& str() const {
+    return entry->first;
+  }
+  uint32_t key() const {
+    return entry->second;
+  }
+
+  operator const string&() const {
+    return str();
+  }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const tag_name_t& name) {
+  out << name.str();
+  return out;
+}
+
+/**
+ * The tag names given to the items of one journal, each interned once.
+ * Like the rest of the journal, the table is not synchronized.
+ */
+class tag_names_t : public noncopyable
+{
+  // Spellings are hashed and compared without regard to case one
+  // character at a time, so that looking one up makes no upper case copy.
+  struct key_hash {
+    std::size_t operator()(const string& name) const;
+  };
+  struct key_equal {
+    bool operator()(const string& left, const string& right) const;
+  };
+
+  // A deque keeps each spelling's entry in place as names are added,
+  // since every tag_name_t points at its own.
+  std::deque<tag_name_t::entry_t>                          names;
+  std::unordered_map<string, const tag_name_t::entry_t *>  ids;
+  std::unordered_map<string, uint32_t, key_hash, key_equal> keys;
+
+public:
+  // The table of the most recently created journal that still exists,
+  // in which items intern the tag names they are given.
+  static tag_names_t * current;
+
+  tag_name_t intern(const string& name);
+
+  // Returns the key shared by every spelling of NAME, or no_key if no
+  // item has been given that tag.
+  uint32_t find_key(const string& name) const {
+    std::unordered_map<string, uint32_t, key_hash, key_equal>::const_iterator
+      i = keys.find(name);
+    return i != keys.end() ? (*i).second : tag_name_t::no_key;
+  }
+};
+
+/**
+ * The tags of an item, kept in a small vector sorted by name.  Items
+ * rarely have more than a few tags, so finding one is a scan for its
+ * key rather than a walk of a tree of strings.
+ */
+class tag_map_t
+{
+public:
+  typedef std::pair<optional<value_t>, bool>   data_type;
+  typedef std::pair<tag_name_t, data_type>     value_type;
+  typedef std::vector<value_type>::iterator       iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+private:
+  tag_names_t *           names;
+  std::vector<value_type> tags;
+
+public:
+  explicit tag_map_t(tag_names_t& _names) : names(&_names) {}
+
+  iterator begin() {
+    return tags.begin();
+  }
+  iterator end() {
+    return tags.end();
+  }
+  const_iterator begin() const {
+    return tags.begin();
+  }
+  const_iterator end() const {
+    return tags.end();
+  }
+  std::size_t size() const {
+    return tags.size();
+  }
+  bool empty() const {
+    return tags.empty();
+  }
+
+  iterator find(const string& tag) {
+    return find_key(names->find_key(tag));
+  }
+  const_iterator find(const string& tag) const {
+    return find_key(names->find_key(tag));
+  }
+  iterator find_key(uint32_t key) {
+    if (key != tag_name_t::no_key)
+      for (iterator i = tags.begin(); i != tags.end(); i++)
+        if ((*i).first.key() == key)
+          return i;
+    return tags.end();
+  }
+  const_iterator find_key(uint32_t key) const {
+    if (key != tag_name_t::no_key)
+      for (const_iterator i = tags.begin(); i != tags.end(); i++)
+        if ((*i).first.key() == key)
+          return i;
+    return tags.end();
+  }
+
+  std::pair<iterator, bool> insert(const string& tag, const data_type& data);
+};
+
+class item_t : public supports_flags<uint_least16_t>, public scope_t,
+               public arena_object_t
 {
 public:
 #define ITEM_NORMAL            0x00 // no flags at all, a basic posting
@@ -90,16 +229,14 @@ public:
 
   enum state_t { UNCLEARED = 0, CLEARED, PENDING };
 
-  typedef std::pair<optional<value_t>, bool> tag_data_t;
-  typedef std::map<string, tag_data_t,
-                   std::function<bool(string, string)> > string_map;
+  typedef tag_map_t::data_type tag_data_t;
 
   state_t              _state;
   optional<date_t>     _date;
   optional<date_t>     _date_aux;
   optional<string>     note;
   optional<position_t> pos;
-  optional<string_map> metadata;
+  optional<tag_map_t>  metadata;
 
   item_t(flags_t _flags = ITEM_NORMAL, const optional<string>& _note = none)
     : supports_flags<uint_least16_t>(_flags), _state(UNCLEARED), note(_note)
@@ -159,7 +296,7 @@ public:
                                     const optional<mask_t>& value_mask = none,
                                     bool                    inherit    = true) const;
 
-  virtual string_map::iterator
+  virtual tag_map_t::iterator
   set_tag(const string&            tag,
           const optional<value_t>& value              = none,
           const bool               overwrite_existing = true);
@@ -211,7 +348,7 @@ value_t get_comment(item_t& item);
 void    print_item(std::ostream& out, const item_t& item,
                    const string& prefix = "");
 string  item_context(const item_t& item, const string& desc);
-void    put_metadata(property_tree::ptree& pt, const item_t::string_map& metadata);
+void    put_metadata(property_tree::ptree& pt, const tag_map_t& metadata);
 
 } // namespace ledger
 
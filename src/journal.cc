@@ -45,6 +45,12 @@ namespace ledger {
 journal_t::journal_t()
 {
   initialize();
+
+  // Items are given tag names in the newest journal's table; once it is
+  // gone, in that of the journal created before it.
+  previous_tag_names   = tag_names_t::current;
+  tag_names_t::current = &tag_names;
+
   TRACE_CTOR(journal_t, "");
 }
 
@@ -68,8 +74,13 @@ journal_t::~journal_t()
 {
   TRACE_DTOR(journal_t);
 
-  // Don't bother unhooking each xact's posts from the accounts they refer to,
-  // because all accounts are about to be deleted.
+  // Don't bother unhooking each xact's posts from the accounts they refer to
+  // one at a time, because all accounts are about to be deleted.  Emptying
+  // their posting lists first keeps each account_t::remove_post cheap.
+  master->clear_posts();
+
+  // Most xacts and posts live in the arena, so deleting them only runs
+  // their destructors; the arena's storage is freed after this.
   foreach (xact_t * xact, xacts)
     checked_delete(xact);
 
@@ -80,6 +91,9 @@ journal_t::~journal_t()
     checked_delete(xact);
 
   checked_delete(master);
+
+  if (tag_names_t::current == &tag_names)
+    tag_names_t::current = previous_tag_names;
 }
 
 void journal_t::initialize()
@@ -91,13 +105,16 @@ void journal_t::initialize()
   fixed_commodities = false;
   fixed_metadata    = false;
   current_context   = NULL;
+  directives        = 0;
   was_loaded        = false;
+  cacheable         = true;
   force_checking    = false;
   check_payees      = false;
   day_break         = false;
   checking_style    = CHECK_NORMAL;
   recursive_aliases = false;
   no_aliases        = false;
+  reloadable        = false;
 }
 
 void journal_t::add_account(account_t * acct)
@@ -107,12 +124,27 @@ void journal_t::add_account(account_t * acct)
 
 bool journal_t::remove_account(account_t * acct)
 {
+  account_index.clear();
+  alias_index.clear();
+  auto_xacts_index.clear();
+
   return master->remove_account(acct);
 }
 
 account_t * journal_t::find_account(const string& name, bool auto_create)
 {
-  return master->find_account(name, auto_create);
+  accounts_index_t::const_iterator i = account_index.find(name);
+  if (i != account_index.end())
+    return (*i).second;
+
+  account_t * account = master->find_account(name, auto_create);
+
+  // Temporary accounts may be deleted while the journal lives on, so
+  // they are never remembered.
+  if (account && ! account->has_flags(ACCOUNT_TEMP))
+    account_index.insert(accounts_index_t::value_type(name, account));
+
+  return account;
 }
 
 account_t * journal_t::find_account_re(const string& regexp)
@@ -129,17 +161,19 @@ account_t * journal_t::register_account(const string& name, post_t * post,
 
   // Create the account object and associate it with the journal; this
   // is registering the account.
-  if (! result)
-    result = master_account->find_account(name);
+  if (! result) {
+    if (master_account == master)
+      result = find_account(name);
+    else
+      result = master_account->find_account(name);
+  }
 
   // If the account name being registered is "Unknown", check whether
   // the payee indicates an account that should be used.
   if (result->name == _("Unknown")) {
-    foreach (account_mapping_t& value, payees_for_unknown_accounts) {
-      if (post && value.first.match(post->xact->payee)) {
-        result = value.second;
-        break;
-      }
+    if (post) {
+      if (account_t * account = find_account_for_payee(post->xact->payee))
+        result = account;
     }
   }
 
@@ -167,6 +201,23 @@ account_t * journal_t::register_account(const string& name, post_t * post,
 }
 
 account_t * journal_t::expand_aliases(string name) {
+  if (no_aliases || account_aliases.empty())
+    return NULL;
+
+  // The expansion of a name only changes when the aliases do, at which
+  // point alias_index is cleared.
+  accounts_index_t::const_iterator i = alias_index.find(name);
+  if (i != alias_index.end())
+    return (*i).second;
+
+  account_t * result = expand_aliases_uncached(name);
+  if (! result || ! result->has_flags(ACCOUNT_TEMP))
+    alias_index.insert(accounts_index_t::value_type(name, result));
+
+  return result;
+}
+
+account_t * journal_t::expand_aliases_uncached(string name) {
   // Aliases are expanded recursively, so if both alias Foo=Bar:Foo and
   // alias Bar=Baaz:Bar are in effect, first Foo will be expanded to Bar:Foo,
   // then Bar:Foo will be expanded to Baaz:Bar:Foo.
@@ -249,16 +300,40 @@ string journal_t::register_payee(const string& name, xact_t * xact)
     }
   }
 
-  foreach (payee_alias_mapping_t& value, payee_alias_mappings) {
-    if (value.first.match(name)) {
-      payee = value.second;
-      break;
-    }
-  }
+  if (const payee_alias_mapping_t * alias = find_payee_alias(name))
+    payee = alias->second;
 
   return payee.empty() ? name : payee;
 }
 
+namespace {
+  template <typename T>
+  const T * first_matching(mask_index_t& index, const std::vector<T>& rules,
+                           const string& text)
+  {
+    if (index.size() > rules.size())
+      index.clear();
+    for (std::size_t i = index.size(); i < rules.size(); i++)
+      index.add(rules[i].first);
+
+    std::size_t rule = index.find(text);
+    return rule != mask_index_t::npos ? &rules[rule] : NULL;
+  }
+}
+
+const payee_alias_mapping_t *
+journal_t::find_payee_alias(const string& name)
+{
+  return first_matching(payee_alias_index, payee_alias_mappings, name);
+}
+
+account_t * journal_t::find_account_for_payee(const string& payee)
+{
+  const account_mapping_t * mapping =
+    first_matching(unknown_account_index, payees_for_unknown_accounts, payee);
+  return mapping ? mapping->second : NULL;
+}
+
 void journal_t::register_commodity(commodity_t& comm,
                                    variant<int, xact_t *, post_t *> context)
 {
@@ -351,7 +426,7 @@ namespace {
     post_t * post = context.which() == 2 ? boost::get<post_t *>(context) : NULL;
 
     if ((xact || post) && xact ? xact->metadata : post->metadata) {
-      foreach (const item_t::string_map::value_type& pair,
+      foreach (const tag_map_t::value_type& pair,
                xact ? *xact->metadata : *post->metadata) {
         const string& key(pair.first);
 
@@ -459,10 +534,110 @@ bool journal_t::add_xact(xact_t * xact)
   return true;
 }
 
+void journal_t::index_auto_xacts()
+{
+  indexed_auto_xacts.assign(auto_xacts.begin(), auto_xacts.end());
+  auto_xacts_index.clear();
+
+  general_auto_xacts.clear();
+  for (std::size_t id = 0; id < indexed_auto_xacts.size(); id++)
+    if (! indexed_auto_xacts[id]->try_quick_match)
+      general_auto_xacts.push_back(id);
+}
+
+const auto_xact_ids_t& journal_t::auto_xacts_matching(post_t& post)
+{
+  const account_t * account = post.reported_account();
+
+  auto_xacts_index_t::const_iterator i = auto_xacts_index.find(account);
+  if (i != auto_xacts_index.end())
+    return (*i).second;
+
+  auto_xact_ids_t matching;
+  for (std::size_t id = 0; id < indexed_auto_xacts.size(); id++) {
+    auto_xact_t * auto_xact = indexed_auto_xacts[id];
+    if (! auto_xact->try_quick_match)
+      continue;
+
+    try {
+      if (auto_xact->quick_match(post))
+        matching.push_back(id);
+    }
+    catch (...) {
+      DEBUG("xact.extend.fail",
+            "The quick matcher failed, going back to regular eval");
+      auto_xact->try_quick_match = false;
+      index_auto_xacts();
+      return auto_xacts_matching(post);
+    }
+  }
+
+  return (*auto_xacts_index.insert
+          (auto_xacts_index_t::value_type(account, matching)).first).second;
+}
+
+namespace {
+  typedef std::pair<std::size_t, post_t *> auto_xact_match_t;
+
+  struct auto_xact_match_less {
+    bool operator()(const auto_xact_match_t& left,
+                    const auto_xact_match_t& right) const {
+      return left.first < right.first;
+    }
+  };
+}
+
 void journal_t::extend_xact(xact_base_t * xact)
 {
-  foreach (auto_xact_t * auto_xact, auto_xacts)
-    auto_xact->extend_xact(*xact, *current_context);
+  if (auto_xacts.empty())
+    return;
+
+  if (indexed_auto_xacts.size() != auto_xacts.size())
+    index_auto_xacts();
+
+  // Rather than trying every automated transaction against every posting,
+  // look up which of those that only test the account match each
+  // posting's account.  If one of them turns out to test more than that,
+  // it joins the general ones and the lookup starts over.
+  std::vector<auto_xact_match_t> matches;
+  for (bool complete = false; ! complete; ) {
+    const std::size_t general_count = general_auto_xacts.size();
+
+    matches.clear();
+    complete = true;
+    foreach (post_t * post, xact->posts) {
+      if (post->has_flags(ITEM_GENERATED))
+        continue;
+
+      foreach (std::size_t id, auto_xacts_matching(*post))
+        matches.push_back(auto_xact_match_t(id, post));
+
+      if (general_auto_xacts.size() != general_count) {
+        complete = false;
+        break;
+      }
+    }
+  }
+  std::stable_sort(matches.begin(), matches.end(), auto_xact_match_less());
+
+  // Apply them all in the order they were defined, as before.
+  auto_xact_ids_t::const_iterator general = general_auto_xacts.begin();
+  std::vector<auto_xact_match_t>::const_iterator match = matches.begin();
+
+  while (general != general_auto_xacts.end() || match != matches.end()) {
+    if (general != general_auto_xacts.end() &&
+        (match == matches.end() || *general < (*match).first)) {
+      indexed_auto_xacts[*general++]->extend_xact(*xact, *current_context);
+    } else {
+      const std::size_t id = (*match).first;
+      posts_list        matching_posts;
+      for (; match != matches.end() && (*match).first == id; match++)
+        matching_posts.push_back((*match).second);
+
+      indexed_auto_xacts[id]->apply_to_posts(*xact, *current_context,
+                                             matching_posts);
+    }
+  }
 }
 
 bool journal_t::remove_xact(xact_t * xact)
@@ -483,7 +658,7 @@ bool journal_t::remove_xact(xact_t * xact)
   return true;
 }
 
-std::size_t journal_t::read(parse_context_stack_t& context)
+std::size_t journal_t::read(parse_context_stack_t& context, bool keep_xdata)
 {
   std::size_t count = 0;
   try {
@@ -503,12 +678,7 @@ std::size_t journal_t::read(parse_context_stack_t& context)
       current.master = master;
 
     count = read_textual(context);
-    if (count > 0) {
-      if (! current.pathname.empty())
-        sources.push_back(fileinfo_t(current.pathname));
-      else
-        sources.push_back(fileinfo_t());
-    }
+    add_source(current);
   }
   catch (...) {
     clear_xdata();
@@ -518,12 +688,143 @@ std::size_t journal_t::read(parse_context_stack_t& context)
 
   // xdata may have been set for some accounts and transaction due to the use
   // of balance assertions or other calculations performed in valexpr-based
-  // posting amounts.
-  clear_xdata();
+  // posting amounts.  It is kept when reading in the middle of a report,
+  // whose own xdata would otherwise be lost.
+  if (! keep_xdata)
+    clear_xdata();
 
   return count;
 }
 
+namespace {
+  // Checksum the first SIZE bytes of a file.  This need not be strong,
+  // only likely to notice an edit made before that point.
+  uint64_t checksum_file(const path& pathname, uintmax_t size)
+  {
+    ifstream in(pathname, std::ios::in | std::ios::binary);
+    uint64_t sum = 0xcbf29ce484222325ULL;
+    char     buf[65536];
+    while (size > 0 && in.good()) {
+      std::streamsize len =
+        static_cast<std::streamsize>(std::min<uintmax_t>(size, sizeof(buf)));
+      in.read(buf, len);
+      len = in.gcount();
+      for (std::streamsize i = 0; i < len; i++)
+        sum = (sum ^ static_cast<unsigned char>(buf[i])) * 0x100000001b3ULL;
+      size -= static_cast<uintmax_t>(len);
+    }
+    return sum;
+  }
+}
+
+void journal_t::add_source(const parse_context_t& context)
+{
+  if (context.pathname.empty() || ! is_regular_file(context.pathname)) {
+    sources.push_back(fileinfo_t());
+    return;
+  }
+
+  fileinfo_t info(context.pathname);
+
+  // Reading can only resume at the end of a file that was read up to a
+  // complete line, and only if it has not changed since it was read.
+  if (reloadable && context.resumable &&
+      info.size == static_cast<uintmax_t>(context.curr_pos)) {
+    if (info.size > 0) {
+      ifstream in(context.pathname, std::ios::in | std::ios::binary);
+      in.seekg(static_cast<std::streamoff>(info.size - 1));
+      info.resumable = in.get() == '\n';
+    } else {
+      info.resumable = true;
+    }
+    if (info.resumable) {
+      info.lines      = context.linenum;
+      info.directives = directives;
+      info.checksum   = checksum_file(context.pathname, info.size);
+    }
+  }
+  sources.push_back(info);
+}
+
+bool journal_t::read_appended(parse_context_stack_t& context,
+                              account_t * master_account)
+{
+  if (sources.empty())
+    return false;
+
+  // Appended text can only be read on its own if nothing at all was read
+  // after the end of the file it was appended to.
+  std::size_t last = 0;
+  foreach (const fileinfo_t& info, sources)
+    last = std::max(last, info.directives);
+
+  std::list<std::list<fileinfo_t>::iterator> grown;
+  try {
+    for (std::list<fileinfo_t>::iterator i = sources.begin();
+         i != sources.end();
+         i++) {
+      if (i->from_stream || ! i->filename)
+        continue;
+      if (! exists(*i->filename))
+        return false;
+
+      uintmax_t  size    = file_size(*i->filename);
+      datetime_t modtime =
+        posix_time::from_time_t(last_write_time(*i->filename));
+      if (size == i->size && modtime == i->modtime)
+        continue;
+
+      if (! i->resumable || i->directives != last || size <= i->size)
+        return false;
+
+      // If the first line appended is indented, it continues whatever
+      // the file ended with.
+      ifstream in(*i->filename, std::ios::in | std::ios::binary);
+      in.seekg(static_cast<std::streamoff>(i->size));
+      int c = in.peek();
+      if (c == ' ' || c == '\t')
+        return false;
+
+      if (checksum_file(*i->filename, i->size) != i->checksum) {
+        DEBUG("journal.appended",
+              "File " << *i->filename << " was changed, not appended to");
+        return false;
+      }
+      grown.push_back(i);
+    }
+  }
+  catch (const filesystem::filesystem_error&) {
+    return false;
+  }
+
+  foreach (std::list<fileinfo_t>::iterator i, grown) {
+    INFO("Reading what was appended to " << *i->filename);
+
+    context.push(*i->filename);
+
+    parse_context_t& current(context.get_current());
+    current.journal = this;
+    current.master  = master_account;
+    current.linenum = i->lines;
+    current.stream->seekg(static_cast<std::streamoff>(i->size));
+    try {
+      read(context);
+    }
+    catch (...) {
+      // The journal now holds only part of what was appended, so the
+      // file must be read from the start the next time.
+      i->resumable = false;
+      context.pop();
+      throw;
+    }
+    context.pop();
+
+    // Reading the file recorded it as a source again, where it now ends.
+    sources.erase(i);
+  }
+  return true;
+}
+
 bool journal_t::has_xdata()
 {
   foreach (xact_t * xact, xacts)
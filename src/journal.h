@@ -43,6 +43,8 @@
 #define _JOURNAL_H
 
 #include "utils.h"
+#include "arena.h"
+#include "item.h"
 #include "times.h"
 #include "mask.h"
 #include "expr.h"
@@ -62,13 +64,18 @@ typedef std::list<xact_t *>              xacts_list;
 typedef std::list<auto_xact_t *>         auto_xacts_list;
 typedef std::list<period_xact_t *>       period_xacts_list;
 typedef std::pair<mask_t, string>        payee_alias_mapping_t;
-typedef std::list<payee_alias_mapping_t> payee_alias_mappings_t;
+typedef std::vector<payee_alias_mapping_t> payee_alias_mappings_t;
 typedef std::pair<string, string>        payee_uuid_mapping_t;
 typedef std::list<payee_uuid_mapping_t>  payee_uuid_mappings_t;
 typedef std::pair<mask_t, account_t *>   account_mapping_t;
-typedef std::list<account_mapping_t>     account_mappings_t;
+typedef std::vector<account_mapping_t>   account_mappings_t;
 typedef std::map<string, account_t *>    accounts_map;
+typedef std::unordered_map<string, account_t *> accounts_index_t;
 typedef std::map<string, xact_t *>       checksum_map_t;
+typedef std::vector<auto_xact_t *>       auto_xacts_vector;
+typedef std::vector<std::size_t>         auto_xact_ids_t;
+typedef std::unordered_map<const account_t *, auto_xact_ids_t>
+                                         auto_xacts_index_t;
 
 typedef std::multimap<string, expr_t::check_expr_pair> tag_check_exprs_map;
 
@@ -77,23 +84,38 @@ class journal_t : public noncopyable
 public:
   struct fileinfo_t
   {
-    optional<path> filename;
-    uintmax_t      size;
-    datetime_t     modtime;
-    bool           from_stream;
+    optional<path>  filename;
+    uintmax_t       size;
+    datetime_t      modtime;
+    bool            from_stream;
 
-    fileinfo_t() : size(0), from_stream(true) {
+    // When a file is resumable, reading may later pick up again at its
+    // end if it has only been appended to since.  This records where
+    // reading stopped, and a checksum of everything read before that.
+    // It is only worked out for a reloadable journal, since it means
+    // reading the whole file a second time.
+    bool            resumable;
+    std::size_t     lines;
+    std::size_t     directives;
+    boost::uint64_t checksum;
+
+    fileinfo_t()
+      : size(0), from_stream(true), resumable(false), lines(0),
+        directives(0), checksum(0) {
       TRACE_CTOR(journal_t::fileinfo_t, "");
     }
     fileinfo_t(const path& _filename)
-      : filename(_filename), from_stream(false) {
+      : filename(_filename), from_stream(false), resumable(false),
+        lines(0), directives(0), checksum(0) {
       size    = file_size(*filename);
       modtime = posix_time::from_time_t(last_write_time(*filename));
       TRACE_CTOR(journal_t::fileinfo_t, "const path&");
     }
     fileinfo_t(const fileinfo_t& info)
       : filename(info.filename), size(info.size),
-        modtime(info.modtime), from_stream(info.from_stream)
+        modtime(info.modtime), from_stream(info.from_stream),
+        resumable(info.resumable), lines(info.lines),
+        directives(info.directives), checksum(info.checksum)
     {
       TRACE_CTOR(journal_t::fileinfo_t, "copy");
     }
@@ -107,29 +129,46 @@ public:
   xacts_list             xacts;
   auto_xacts_list        auto_xacts;
   period_xacts_list      period_xacts;
+  arena_t                arena;   // storage for parsed xacts and posts
   std::list<fileinfo_t>  sources;
+  std::size_t            directives;
   std::set<string>       known_payees;
   std::set<string>       known_tags;
+  tag_names_t            tag_names; // interned names of items' tags
+  tag_names_t *          previous_tag_names;
   bool                   fixed_accounts;
   bool                   fixed_payees;
   bool                   fixed_commodities;
   bool                   fixed_metadata;
   bool                   was_loaded;
+  bool                   cacheable;
   bool                   force_checking;
   bool                   check_payees;
   bool                   day_break;
   bool                   recursive_aliases;
   bool                   no_aliases;
+  bool                   reloadable;  // sources may resume on reload
   payee_alias_mappings_t payee_alias_mappings;
   payee_uuid_mappings_t  payee_uuid_mappings;
   account_mappings_t     account_mappings;
   accounts_map           account_aliases;
+  accounts_index_t       account_index; // full names found under master
+  accounts_index_t       alias_index;   // results of expand_aliases
   account_mappings_t     payees_for_unknown_accounts;
   checksum_map_t         checksum_map;
+  auto_xacts_vector      indexed_auto_xacts;
+  auto_xacts_index_t     auto_xacts_index;   // matching account-only ones
+  auto_xact_ids_t        general_auto_xacts; // those not only on accounts
   tag_check_exprs_map    tag_check_exprs;
   optional<expr_t>       value_expr;
   parse_context_t *      current_context;
 
+  // Matchers over payee_alias_mappings and payees_for_unknown_accounts.
+  // They catch up with rules appended to those lists on their own, but
+  // must be cleared whenever a list is replaced.
+  mask_index_t           payee_alias_index;
+  mask_index_t           unknown_account_index;
+
   enum checking_style_t {
     CHECK_PERMISSIVE,
     CHECK_NORMAL,
@@ -163,6 +202,9 @@ public:
   account_t * register_account(const string& name, post_t * post,
                                account_t * master = NULL);
   string      register_payee(const string& name, xact_t * xact);
+
+  const payee_alias_mapping_t * find_payee_alias(const string& name);
+  account_t * find_account_for_payee(const string& payee);
   void        register_commodity(commodity_t& comm,
                                  variant<int, xact_t *, post_t *> context);
   void        register_metadata(const string& key, const value_t& value,
@@ -170,6 +212,8 @@ public:
 
   bool add_xact(xact_t * xact);
   void extend_xact(xact_base_t * xact);
+  // The storage of a removed xact may belong to this journal's arena,
+  // so it must not be deleted after the journal is.
   bool remove_xact(xact_t * xact);
 
   xacts_list::iterator xacts_begin() {
@@ -191,7 +235,10 @@ public:
     return period_xacts.end();
   }
 
-  std::size_t read(parse_context_stack_t& context);
+  std::size_t read(parse_context_stack_t& context, bool keep_xdata = false);
+  bool        read_appended(parse_context_stack_t& context,
+                            account_t * master);
+  void        add_source(const parse_context_t& context);
 
   bool has_xdata();
   void clear_xdata();
@@ -200,6 +247,11 @@ public:
 
 private:
   std::size_t read_textual(parse_context_stack_t& context);
+
+  account_t * expand_aliases_uncached(string name);
+
+  void index_auto_xacts();
+  const auto_xact_ids_t& auto_xacts_matching(post_t& post);
 };
 
 } // namespace ledger
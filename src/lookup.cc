@@ -37,14 +37,18 @@
 namespace ledger {
 
 namespace {
-  typedef std::pair<xact_t *, int> score_entry_t;
-  typedef std::deque<score_entry_t> scorecard_t;
+  typedef std::pair<std::size_t, int> score_entry_t;
+  typedef std::vector<score_entry_t>  scorecard_t;
   typedef std::map<uint32_t, std::size_t> char_positions_map;
 
+  // Higher scores first, and among equal scores, the transaction seen
+  // first.
   struct score_sorter {
     bool operator()(const score_entry_t& left,
                     const score_entry_t& right) const {
-      return left.second > right.second;
+      if (left.second != right.second)
+        return left.second > right.second;
+      return left.first < right.first;
     }
   };
 
@@ -57,60 +61,11 @@ namespace {
       return left.second < right.second;
     }
   };
-}
-
-std::pair<xact_t *, account_t *>
-lookup_probable_account(const string& ident,
-                        xacts_list::reverse_iterator iter,
-                        xacts_list::reverse_iterator end,
-                        account_t * ref_account)
-{
-  scorecard_t scores;
-
-#if !HAVE_BOOST_REGEX_UNICODE
-    string lident = ident;
-    to_lower(lident);
-    unistring lowered_ident(lident);
-#else
-    // jww (2010-03-07): Not yet implemented
-    unistring lowered_ident(ident);
-#endif
-
-  DEBUG("lookup.account",
-        "Looking up identifier '" << lowered_ident.extract() << "'");
-#if DEBUG_ON
-  if (ref_account != NULL)
-    DEBUG("lookup.account",
-          "  with reference account: " << ref_account->fullname());
-#endif
-
-  xact_t * xact;
-  while (iter != end && (xact = *iter++) != NULL) {
-#if 0
-    // Only consider transactions from the last two years (jww (2010-03-07):
-    // make this an option)
-    if ((CURRENT_DATE() - xact->date()).days() > 700)
-      continue;
-#endif
-
-    // An exact match is worth a score of 100 and terminates the search
-    if (ident == xact->payee) {
-      DEBUG("lookup", "  we have an exact match, score = 100");
-      scores.push_back(score_entry_t(xact, 100));
-      break;
-    }
-
-#if !HAVE_BOOST_REGEX_UNICODE
-    string payee = xact->payee;
-    to_lower(payee);
-    unistring value_key(payee);
-#else
-    // jww (2010-03-07): Not yet implemented
-    unistring value_key(xact->payee);
-#endif
-
-    DEBUG("lookup", "Considering payee: " << value_key.extract());
 
+  // The score of VALUE_KEY, a lowercased payee, as a match for
+  // LOWERED_IDENT.
+  int score_payee(const unistring& lowered_ident, const unistring& value_key)
+  {
     std::size_t        index          = 0;
     std::size_t        last_match_pos = unistring::npos;
     int                bonus          = 0;
@@ -230,9 +185,122 @@ lookup_probable_account(const string& ident,
       index++;
     }
 
-    // Only consider payees with a score of 30 or greater
-    if (score >= 30)
-      scores.push_back(score_entry_t(xact, score));
+    return score;
+  }
+
+  // The bit for CH in a payee's signature, which has one set for every
+  // character the payee contains.
+  inline uint64_t signature_bit(const uint32_t ch) {
+    return uint64_t(1) << (ch % 64);
+  }
+}
+
+payee_index_t::payee_index_t(xacts_list::reverse_iterator iter,
+                             xacts_list::reverse_iterator end)
+{
+  xact_t * xact;
+  while (iter != end && (xact = *iter++) != NULL) {
+    std::pair<payee_ids_map::iterator, bool> result =
+      payee_ids.insert(payee_ids_map::value_type(xact->payee, payees.size()));
+    if (result.second) {
+      payees.push_back(payee_t());
+      payee_t& payee(payees.back());
+
+#if !HAVE_BOOST_REGEX_UNICODE
+      string lowered = xact->payee;
+      to_lower(lowered);
+      payee.lowered = unistring(lowered);
+#else
+      // jww (2010-03-07): Not yet implemented
+      payee.lowered = unistring(xact->payee);
+#endif
+
+      payee.signature = 0;
+      foreach (const uint32_t& ch, payee.lowered.utf32chars)
+        payee.signature |= signature_bit(ch);
+    }
+
+    payees[(*result.first).second].positions.push_back(xacts.size());
+    xacts.push_back(xact);
+  }
+
+  DEBUG("lookup", "Indexed " << xacts.size() << " transactions with "
+        << payees.size() << " distinct payees");
+}
+
+std::pair<xact_t *, account_t *>
+payee_index_t::lookup_probable_account(const string& ident,
+                                       account_t *   ref_account) const
+{
+  scorecard_t scores;
+
+#if !HAVE_BOOST_REGEX_UNICODE
+    string lident = ident;
+    to_lower(lident);
+    unistring lowered_ident(lident);
+#else
+    // jww (2010-03-07): Not yet implemented
+    unistring lowered_ident(ident);
+#endif
+
+  DEBUG("lookup.account",
+        "Looking up identifier '" << lowered_ident.extract() << "'");
+#if DEBUG_ON
+  if (ref_account != NULL)
+    DEBUG("lookup.account",
+          "  with reference account: " << ref_account->fullname());
+#endif
+
+  // An exact match is worth a score of 100 and ends the search, so only
+  // transactions seen before the first one with this payee are scored.
+  std::size_t limit = xacts.size();
+  payee_ids_map::const_iterator exact = payee_ids.find(ident);
+  if (exact != payee_ids.end()) {
+    DEBUG("lookup", "  we have an exact match, score = 100");
+    limit = payees[(*exact).second].positions.front();
+    scores.push_back(score_entry_t(limit, 100));
+  }
+
+  // The most each letter of the identifier could add to a payee's score,
+  // if the payee has that letter, and what it adds if it does not (see
+  // score_payee).  A payee whose best possible score is under 30 cannot
+  // be chosen, and need not be scored.
+  std::vector<uint64_t> bits;
+  std::vector<int>      if_found;
+  std::vector<int>      if_missing;
+  std::size_t           index = 0;
+  foreach (const uint32_t& ch, lowered_ident.utf32chars) {
+    int divisor = int(index / 5) + 1;
+    bits.push_back(signature_bit(ch));
+    if_found.push_back(int(double(10 + (index > 2 ? int(index) - 2 : 0)) /
+                           divisor));
+    if_missing.push_back(int(-1.0 / divisor));
+    index++;
+  }
+
+  for (std::size_t id = 0; id < payees.size(); id++) {
+    const payee_t& payee(payees[id]);
+    if (payee.positions.front() >= limit ||
+        (exact != payee_ids.end() && id == (*exact).second))
+      continue;
+
+    int best = 0;
+    for (std::size_t i = 0; i < bits.size(); i++)
+      best += (payee.signature & bits[i]) ? if_found[i] : if_missing[i];
+    if (best < 30)
+      continue;
+
+    DEBUG("lookup", "Considering payee: " << payee.lowered.extract());
+
+    // Only consider payees with a score of 30 or greater.  At most five
+    // transactions are used below, so no payee can add more than that.
+    int score = score_payee(lowered_ident, payee.lowered);
+    if (score >= 30) {
+      for (std::size_t i = 0;
+           i < payee.positions.size() && i < 5 && payee.positions[i] < limit;
+           i++)
+        scores.push_back(score_entry_t(payee.positions[i], score));
+    }
   }
 
   // Sort the results by descending score, then look at every account ever
@@ -240,19 +308,20 @@ lookup_probable_account(const string& ident,
   // "decay" any latter accounts, so that we give recently used accounts a
   // slightly higher rating in case of a tie.
 
-  std::stable_sort(scores.begin(), scores.end(), score_sorter());
+  std::sort(scores.begin(), scores.end(), score_sorter());
 
   scorecard_t::iterator si        = scores.begin();
   int                   decay     = 0;
-  xact_t *              best_xact = si != scores.end() ? (*si).first : NULL;
+  xact_t *              best_xact = (si != scores.end() ?
+                                     xacts[(*si).first] : NULL);
   account_use_map       account_usage;
 
   for (int i = 0; i < 5 && si != scores.end(); i++, si++) {
     DEBUG("lookup.account",
           "Payee: " << std::setw(5) << std::right << (*si).second <<
-          " - " << (*si).first->payee);
+          " - " << xacts[(*si).first]->payee);
 
-    foreach (post_t * post, (*si).first->posts) {
+    foreach (post_t * post, xacts[(*si).first]->posts) {
       if (! post->has_flags(ITEM_TEMP | ITEM_GENERATED) &&
           post->account != ref_account &&
           ! post->account->has_flags(ACCOUNT_TEMP | ACCOUNT_GENERATED)) {
@@ -284,4 +353,25 @@ lookup_probable_account(const string& ident,
   }
 }
 
+xact_t * payee_index_t::find_payee(const mask_t& mask) const
+{
+  // Each payee is matched once, and the one used first wins.
+  std::size_t first = xacts.size();
+  foreach (const payee_t& payee, payees)
+    if (payee.positions.front() < first &&
+        mask.match(xacts[payee.positions.front()]->payee))
+      first = payee.positions.front();
+
+  return first < xacts.size() ? xacts[first] : NULL;
+}
+
+std::pair<xact_t *, account_t *>
+lookup_probable_account(const string& ident,
+                        xacts_list::reverse_iterator iter,
+                        xacts_list::reverse_iterator end,
+                        account_t * ref_account)
+{
+  return payee_index_t(iter, end).lookup_probable_account(ident, ref_account);
+}
+
 } // namespace ledger
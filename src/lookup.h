@@ -43,9 +43,48 @@
 #define _LOOKUP_H
 
 #include "iterators.h"
+#include "unistring.h"
 
 namespace ledger {
 
+/**
+ * @brief An index of the payees of a list of transactions.
+ *
+ * Each distinct payee is kept once, lowercased, with the positions of
+ * the transactions that use it, so that a lookup scores each payee only
+ * once rather than once per transaction.  A signature of the characters
+ * in each payee bounds the score it could reach, so most payees need
+ * not be scored at all.
+ */
+class payee_index_t : public noncopyable
+{
+  struct payee_t {
+    unistring                lowered;
+    uint64_t                 signature;
+    std::vector<std::size_t> positions;
+  };
+
+  typedef std::vector<payee_t>                      payees_vector;
+  typedef std::unordered_map<string, std::size_t>   payee_ids_map;
+
+  std::vector<xact_t *> xacts;
+  payees_vector         payees;
+  payee_ids_map         payee_ids;
+
+public:
+  // The transactions are indexed in the order given, which is the order
+  // lookup_probable_account would have considered them in.
+  payee_index_t(xacts_list::reverse_iterator iter,
+                xacts_list::reverse_iterator end);
+
+  std::pair<xact_t *, account_t *>
+  lookup_probable_account(const string& ident,
+                          account_t * ref_account = NULL) const;
+
+  // The first transaction, in the order given, whose payee matches MASK.
+  xact_t * find_payee(const mask_t& mask) const;
+};
+
 std::pair<xact_t *, account_t *>
 lookup_probable_account(const string& ident,
                         xacts_list::reverse_iterator iter,
@@ -86,4 +86,196 @@ mask_t& mask_t::assign_glob(const string& pat)
   return (*this = re_pat);
 }
 
+namespace {
+  const char * const regex_operators = "\\^$.|?*+()[]{}";
+
+  bool is_plain_char(char c)
+  {
+    return c >= ' ' && c <= '~' && ! std::strchr(regex_operators, c);
+  }
+
+  bool is_plain_text(const string& text)
+  {
+    foreach (char c, text)
+      if (c < ' ' || c > '~')
+        return false;
+    return true;
+  }
+
+  // Reduce pattern to the text it matches literally, if it is no more than
+  // that.  An escaped operator is taken as itself; any other escape, or any
+  // operator besides an outer ^ or $, makes it a real regex.
+  bool literal_text(const string& pattern, string& text,
+                    bool& at_start, bool& at_end)
+  {
+    string::size_type len = pattern.length();
+    string::size_type i   = 0;
+
+    at_start = len > 0 && pattern[0] == '^';
+    at_end   = false;
+    if (at_start)
+      i++;
+
+    text.clear();
+    for (; i < len; i++) {
+      char c = pattern[i];
+      if (c == '\\') {
+        if (i + 1 == len)
+          return false;
+        c = pattern[++i];
+        if (c == '\0' || ! std::strchr(regex_operators, c))
+          return false;
+      }
+      else if (c == '$' && i + 1 == len) {
+        at_end = true;
+        break;
+      }
+      else if (! is_plain_char(c)) {
+        return false;
+      }
+      text += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return true;
+  }
+}
+
+void mask_index_t::add(const mask_t& mask)
+{
+  std::size_t rule = masks.size();
+  masks.push_back(mask);
+
+  string text;
+  literal_t literal;
+  if (literal_text(mask.str(), text, literal.at_start, literal.at_end)) {
+    literal.rule   = rule;
+    literal.length = text.length();
+    literals.push_back(literal);
+    texts.push_back(text);
+  } else {
+    regexes.push_back(rule);
+  }
+  compiled = false;
+}
+
+void mask_index_t::clear()
+{
+  masks.clear();
+  regexes.clear();
+  literals.clear();
+  texts.clear();
+  states.clear();
+  compiled = false;
+}
+
+void mask_index_t::compile()
+{
+  states.clear();
+  states.push_back(state_t());
+
+  for (std::size_t i = 0; i < texts.size(); i++) {
+    std::size_t state = 0;
+    foreach (char c, texts[i]) {
+      std::map<char, std::size_t>::iterator next = states[state].next.find(c);
+      if (next == states[state].next.end()) {
+        states.push_back(state_t());
+        next = states[state].next.insert
+          (std::pair<char, std::size_t>(c, states.size() - 1)).first;
+      }
+      state = (*next).second;
+    }
+    states[state].literals.push_back(i);
+  }
+
+  // Link each state to the longest proper suffix of its text that is also
+  // in the trie, visiting states breadth first so that shorter texts are
+  // always linked before longer ones.
+  std::deque<std::size_t> queue;
+  typedef std::map<char, std::size_t>::value_type edge_t;
+  foreach (const edge_t& edge, states[0].next)
+    queue.push_back(edge.second);
+
+  while (! queue.empty()) {
+    std::size_t state = queue.front();
+    queue.pop_front();
+
+    foreach (const edge_t& edge, states[state].next) {
+      std::size_t fail = states[state].fail;
+      std::map<char, std::size_t>::iterator next;
+      while ((next = states[fail].next.find(edge.first)) ==
+             states[fail].next.end() && fail != 0)
+        fail = states[fail].fail;
+
+      state_t& child(states[edge.second]);
+      child.fail   = next != states[fail].next.end() ? (*next).second : 0;
+      child.output = (! states[child.fail].literals.empty() ?
+                      child.fail : states[child.fail].output);
+      queue.push_back(edge.second);
+    }
+  }
+
+  compiled = true;
+
+  DEBUG("mask.index", "Compiled " << literals.size() << " literal and "
+        << regexes.size() << " regex rules into " << states.size()
+        << " states");
+}
+
+std::size_t mask_index_t::find_literal(const string& text) const
+{
+  std::size_t found = npos;
+
+  // Empty texts match anywhere, unless anchored at both ends.
+  foreach (std::size_t i, states[0].literals) {
+    const literal_t& literal(literals[i]);
+    if (! (literal.at_start && literal.at_end) || text.empty())
+      found = std::min(found, literal.rule);
+  }
+
+  std::size_t state = 0;
+  for (std::size_t pos = 0; pos < text.length(); pos++) {
+    char c = static_cast<char>(std::tolower(static_cast<unsigned char>(text[pos])));
+
+    std::map<char, std::size_t>::const_iterator next;
+    while ((next = states[state].next.find(c)) == states[state].next.end() &&
+           state != 0)
+      state = states[state].fail;
+    state = next != states[state].next.end() ? (*next).second : 0;
+
+    for (std::size_t out = state; out != 0; out = states[out].output) {
+      foreach (std::size_t i, states[out].literals) {
+        const literal_t& literal(literals[i]);
+        if (literal.rule < found &&
+            (! literal.at_start || pos + 1 == literal.length) &&
+            (! literal.at_end || pos + 1 == text.length()))
+          found = literal.rule;
+      }
+    }
+  }
+  return found;
+}
+
+std::size_t mask_index_t::find(const string& text)
+{
+  // Case folding outside of printable ASCII, and line breaks within the
+  // text, are left for the regex engine to decide.
+  if (! is_plain_text(text)) {
+    for (std::size_t rule = 0; rule < masks.size(); rule++)
+      if (masks[rule].match(text))
+        return rule;
+    return npos;
+  }
+
+  if (! compiled)
+    compile();
+
+  std::size_t found = find_literal(text);
+  foreach (std::size_t rule, regexes) {
+    if (rule >= found)
+      break;
+    if (masks[rule].match(text))
+      return rule;
+  }
+  return found;
+}
+
 } // namespace ledger
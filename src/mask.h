@@ -126,6 +126,69 @@ public:
   }
 };
 
+/**
+ * @brief An ordered list of masks, searched for the first that matches.
+ *
+ * Payee aliases and payee-to-account mappings are tried in the order they
+ * were declared, and the first matching rule wins.  Rather than running
+ * every regex in turn, patterns that are plain text (allowing escaped
+ * operators and a leading ^ or trailing $) are gathered into a single
+ * Aho-Corasick automaton, so one pass over the text finds the earliest
+ * literal rule that matches.  Only real regexes declared before that rule
+ * are then tried, in order.
+ */
+class mask_index_t
+{
+public:
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  mask_index_t() : compiled(false) {
+    TRACE_CTOR(mask_index_t, "");
+  }
+  ~mask_index_t() throw() {
+    TRACE_DTOR(mask_index_t);
+  }
+
+  void add(const mask_t& mask);
+  void clear();
+
+  std::size_t size() const {
+    return masks.size();
+  }
+
+  // Returns the position of the first mask matching text, or npos.
+  std::size_t find(const string& text);
+
+private:
+  struct literal_t
+  {
+    std::size_t rule;
+    std::size_t length;
+    bool        at_start;
+    bool        at_end;
+  };
+
+  struct state_t
+  {
+    std::map<char, std::size_t> next;
+    std::size_t                 fail;
+    std::size_t                 output; // nearest fail state with literals
+    std::vector<std::size_t>    literals;
+
+    state_t() : fail(0), output(0) {}
+  };
+
+  std::vector<mask_t>      masks;
+  std::vector<std::size_t> regexes;  // rules that must be run as regexes
+  std::vector<literal_t>   literals;
+  std::vector<string>      texts;    // the lowercased text of each literal
+  std::vector<state_t>     states;
+  bool                     compiled;
+
+  void compile();
+  std::size_t find_literal(const string& text) const;
+};
+
 inline std::ostream& operator<<(std::ostream& out, const mask_t& mask) {
   out << mask.str();
   return out;
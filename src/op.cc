@@ -72,17 +72,15 @@ value_t split_cons_expr(expr_t::ptr_op_t op)
   }
 }
 
-namespace {
-  inline void check_type_context(scope_t& scope, value_t& result)
-  {
-    if (scope.type_required() &&
-        scope.type_context() != value_t::VOID &&
-        result.type() != scope.type_context()) {
-      throw_(calc_error,
-             _f("Expected return of %1%, but received %2%")
-             % result.label(scope.type_context())
-             % result.label());
-    }
+void check_type_context(scope_t& scope, value_t& result)
+{
+  if (scope.type_required() &&
+      scope.type_context() != value_t::VOID &&
+      result.type() != scope.type_context()) {
+    throw_(calc_error,
+           _f("Expected return of %1%, but received %2%")
+           % result.label(scope.type_context())
+           % result.label());
   }
 }
 
@@ -346,6 +346,8 @@ string op_context(const expr_t::ptr_op_t op,
 
 value_t split_cons_expr(expr_t::ptr_op_t op);
 
+void check_type_context(scope_t& scope, value_t& result);
+
 } // namespace ledger
 
 #endif // _OP_H
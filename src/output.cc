@@ -105,21 +105,27 @@ void format_posts::operator()(post_t& post)
       out << prepend_format(bound_scope);
     }
 
+    // The text is built up in a buffer kept from one posting to the
+    // next, and written out in one go.
+    line.clear();
+
     if (last_xact != post.xact) {
       if (last_xact) {
         bind_scope_t xact_scope(report, *last_xact);
-        out << between_format(xact_scope);
+        between_format.calc_into(xact_scope, line);
       }
-      out << first_line_format(bound_scope);
+      first_line_format.calc_into(bound_scope, line);
       last_xact = post.xact;
     }
     else if (last_post && last_post->date() != post.date()) {
-      out << first_line_format(bound_scope);
+      first_line_format.calc_into(bound_scope, line);
     }
     else {
-      out << next_lines_format(bound_scope);
+      next_lines_format.calc_into(bound_scope, line);
     }
 
+    out << line;
+
     post.xdata().add_flags(POST_EXT_DISPLAYED);
     last_post = &post;
   }
@@ -349,7 +355,7 @@ void report_tags::gather_metadata(item_t& item)
 {
   if (! item.metadata)
     return;
-  foreach (const item_t::string_map::value_type& data, *item.metadata) {
+  foreach (const tag_map_t::value_type& data, *item.metadata) {
     string tag(data.first);
     if (report.HANDLED(values) && data.second.first)
       tag += ": " + data.second.first.get().to_string();
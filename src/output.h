@@ -67,6 +67,7 @@ protected:
   post_t *    last_post;
   bool        first_report_title;
   string      report_title;
+  string      line;
 
 public:
   format_posts(report_t& _report, const string& format,
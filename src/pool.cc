@@ -45,6 +45,7 @@ shared_ptr<commodity_pool_t> commodity_pool_t::current_pool;
 commodity_pool_t::commodity_pool_t()
   : default_commodity(NULL), keep_base(false),
     quote_leeway(86400), get_quotes(false),
+    price_lookups(0), price_lookups_cached(0),
     get_commodity_quote(commodity_quote_from_script)
 {
   null_commodity = create("");
@@ -348,7 +349,9 @@ commodity_pool_t::parse_price_directive
 
   price_point_t point;
   point.when = datetime;
-  point.price.parse(symbol_and_price, PARSE_NO_MIGRATE);
+  std::size_t consumed;
+  point.price.parse(symbol_and_price, std::strlen(symbol_and_price), consumed,
+                    PARSE_NO_MIGRATE);
   VERIFY(point.price.valid());
 
   DEBUG("commodity.download", "Looking up symbol: " << symbol);
@@ -82,6 +82,11 @@ public:
   long           quote_leeway;  // --leeway=
   bool           get_quotes;    // --download
 
+  // How often commodity_t::find_price was asked for a price, and how many
+  // of those answers it remembered from before.
+  std::size_t price_lookups;
+  std::size_t price_lookups_cached;
+
   function<optional<price_point_t>
            (commodity_t& commodity, const commodity_t * in_terms_of)>
       get_commodity_quote;
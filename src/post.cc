@@ -359,8 +359,8 @@ namespace {
   }
 
   template <value_t (*Func)(post_t&)>
-  value_t get_wrapper(call_scope_t& scope) {
-    return (*Func)(find_scope<post_t>(scope));
+  scope_accessor_t<post_t> get_wrapper() {
+    return scope_accessor_t<post_t>(Func);
   }
 
   value_t fn_any(call_scope_t& args)
@@ -417,13 +417,13 @@ expr_t::ptr_op_t post_t::lookup(const symbol_t::kind_t kind,
   switch (name[0]) {
   case 'a':
     if (name[1] == '\0' || name == "amount")
-      return WRAP_FUNCTOR(get_wrapper<&get_amount>);
+      return WRAP_FUNCTOR(get_wrapper<&get_amount>());
     else if (name == "account")
       return WRAP_FUNCTOR(get_account);
     else if (name == "account_base")
-      return WRAP_FUNCTOR(get_wrapper<&get_account_base>);
+      return WRAP_FUNCTOR(get_wrapper<&get_account_base>());
     else if (name == "account_id")
-      return WRAP_FUNCTOR(get_wrapper<&get_account_id>);
+      return WRAP_FUNCTOR(get_wrapper<&get_account_id>());
     else if (name == "any")
       return WRAP_FUNCTOR(&fn_any);
     else if (name == "all")
@@ -432,114 +432,114 @@ expr_t::ptr_op_t post_t::lookup(const symbol_t::kind_t kind,
 
   case 'b':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_cost>);
+      return WRAP_FUNCTOR(get_wrapper<&get_cost>());
     break;
 
   case 'c':
     if (name == "code")
-      return WRAP_FUNCTOR(get_wrapper<&get_code>);
+      return WRAP_FUNCTOR(get_wrapper<&get_code>());
     else if (name == "cost")
-      return WRAP_FUNCTOR(get_wrapper<&get_cost>);
+      return WRAP_FUNCTOR(get_wrapper<&get_cost>());
     else if (name == "cost_calculated")
-      return WRAP_FUNCTOR(get_wrapper<&get_is_cost_calculated>);
+      return WRAP_FUNCTOR(get_wrapper<&get_is_cost_calculated>());
     else if (name == "count")
-      return WRAP_FUNCTOR(get_wrapper<&get_count>);
+      return WRAP_FUNCTOR(get_wrapper<&get_count>());
     else if (name == "calculated")
-      return WRAP_FUNCTOR(get_wrapper<&get_is_calculated>);
+      return WRAP_FUNCTOR(get_wrapper<&get_is_calculated>());
     else if (name == "commodity")
       return WRAP_FUNCTOR(&get_commodity);
     else if (name == "checkin")
-      return WRAP_FUNCTOR(get_wrapper<&get_checkin>);
+      return WRAP_FUNCTOR(get_wrapper<&get_checkin>());
     else if (name == "checkout")
-      return WRAP_FUNCTOR(get_wrapper<&get_checkout>);
+      return WRAP_FUNCTOR(get_wrapper<&get_checkout>());
     break;
 
   case 'd':
     if (name == "display_account")
       return WRAP_FUNCTOR(get_display_account);
     else if (name == "depth")
-      return WRAP_FUNCTOR(get_wrapper<&get_account_depth>);
+      return WRAP_FUNCTOR(get_wrapper<&get_account_depth>());
     else if (name == "datetime")
-      return WRAP_FUNCTOR(get_wrapper<&get_datetime>);
+      return WRAP_FUNCTOR(get_wrapper<&get_datetime>());
     break;
 
   case 'h':
     if (name == "has_cost")
-      return WRAP_FUNCTOR(get_wrapper<&get_has_cost>);
+      return WRAP_FUNCTOR(get_wrapper<&get_has_cost>());
     break;
 
   case 'i':
     if (name == "index")
-      return WRAP_FUNCTOR(get_wrapper<&get_count>);
+      return WRAP_FUNCTOR(get_wrapper<&get_count>());
     break;
 
   case 'm':
     if (name == "magnitude")
-      return WRAP_FUNCTOR(get_wrapper<&get_magnitude>);
+      return WRAP_FUNCTOR(get_wrapper<&get_magnitude>());
     break;
 
   case 'n':
     if (name == "note")
-      return WRAP_FUNCTOR(get_wrapper<&get_note>);
+      return WRAP_FUNCTOR(get_wrapper<&get_note>());
     else if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_count>);
+      return WRAP_FUNCTOR(get_wrapper<&get_count>());
     break;
 
   case 'p':
     if (name == "post")
-      return WRAP_FUNCTOR(get_wrapper<&get_this>);
+      return WRAP_FUNCTOR(get_wrapper<&get_this>());
     else if (name == "payee")
-      return WRAP_FUNCTOR(get_wrapper<&get_payee>);
+      return WRAP_FUNCTOR(get_wrapper<&get_payee>());
     else if (name == "primary")
-      return WRAP_FUNCTOR(get_wrapper<&get_commodity_is_primary>);
+      return WRAP_FUNCTOR(get_wrapper<&get_commodity_is_primary>());
     else if (name == "price")
-      return WRAP_FUNCTOR(get_wrapper<&get_price>);
+      return WRAP_FUNCTOR(get_wrapper<&get_price>());
     else if (name == "parent")
-      return WRAP_FUNCTOR(get_wrapper<&get_xact>);
+      return WRAP_FUNCTOR(get_wrapper<&get_xact>());
     break;
 
   case 'r':
     if (name == "real")
-      return WRAP_FUNCTOR(get_wrapper<&get_real>);
+      return WRAP_FUNCTOR(get_wrapper<&get_real>());
     break;
 
   case 't':
     if (name == "total")
-      return WRAP_FUNCTOR(get_wrapper<&get_total>);
+      return WRAP_FUNCTOR(get_wrapper<&get_total>());
     break;
 
   case 'u':
     if (name == "use_direct_amount")
-      return WRAP_FUNCTOR(get_wrapper<&get_use_direct_amount>);
+      return WRAP_FUNCTOR(get_wrapper<&get_use_direct_amount>());
     break;
 
   case 'v':
     if (name == "virtual")
-      return WRAP_FUNCTOR(get_wrapper<&get_virtual>);
+      return WRAP_FUNCTOR(get_wrapper<&get_virtual>());
     else if (name == "value_date")
-      return WRAP_FUNCTOR(get_wrapper<&get_value_date>);
+      return WRAP_FUNCTOR(get_wrapper<&get_value_date>());
     break;
 
   case 'x':
     if (name == "xact")
-      return WRAP_FUNCTOR(get_wrapper<&get_xact>);
+      return WRAP_FUNCTOR(get_wrapper<&get_xact>());
     else if (name == "xact_id")
-      return WRAP_FUNCTOR(get_wrapper<&get_xact_id>);
+      return WRAP_FUNCTOR(get_wrapper<&get_xact_id>());
     break;
 
   case 'N':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_count>);
+      return WRAP_FUNCTOR(get_wrapper<&get_count>());
     break;
 
   case 'O':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_total>);
+      return WRAP_FUNCTOR(get_wrapper<&get_total>());
     break;
 
   case 'R':
     if (name[1] == '\0')
-      return WRAP_FUNCTOR(get_wrapper<&get_real>);
+      return WRAP_FUNCTOR(get_wrapper<&get_real>());
     break;
   }
 
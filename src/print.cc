@@ -141,7 +141,7 @@ namespace {
     out << '\n';
 
     if (xact.metadata) {
-      foreach (const item_t::string_map::value_type& data, *xact.metadata) {
+      foreach (const tag_map_t::value_type& data, *xact.metadata) {
         if (! data.second.second) {
           out << "    ; ";
           if (data.second.first)
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <system.hh>
+
+#include "program.h"
+#include "scope.h"
+#include "item.h"
+#include "post.h"
+#include "xact.h"
+#include "account.h"
+
+namespace ledger {
+
+expr_t::program_t::program_t(ptr_op_t _root)
+  : root(_root), max_depth(0)
+{
+  TRACE_CTOR(program_t, "ptr_op_t");
+}
+
+shared_ptr<expr_t::program_t> expr_t::program_t::lower(ptr_op_t op)
+{
+  shared_ptr<program_t> program(new program_t(op));
+  program->emit(op.get(), 0);
+
+  // A lone constant or unsupported node gains nothing from the machine.
+  if (program->code.size() == 1 &&
+      (program->code[0].code == EVALUATE ||
+       program->code[0].code == PUSH_VALUE))
+    return shared_ptr<program_t>();
+
+  DEBUG("expr.program", "Lowered expression to "
+        << program->code.size() << " instructions");
+  return program;
+}
+
+void expr_t::program_t::emit(op_t * op, std::size_t depth)
+{
+  if (depth + 1 > max_depth)
+    max_depth = depth + 1;
+
+  switch (op->kind) {
+  case op_t::VALUE:
+    code.push_back(instr_t(PUSH_VALUE, op));
+    return;
+
+  case op_t::FUNCTION:
+    if (! emit_accessor(op))
+      code.push_back(instr_t(CALL_FUNCTION, op));
+    return;
+
+  case op_t::O_NOT:
+  case op_t::O_NEG:
+    if (! op->left())
+      break;
+    emit(op->left().get(), depth);
+    code.push_back(instr_t(op->kind == op_t::O_NOT ? NOT : NEG, op));
+    return;
+
+  case op_t::O_EQ:  emit_binary(EQ, op, depth);    return;
+  case op_t::O_LT:  emit_binary(LT, op, depth);    return;
+  case op_t::O_LTE: emit_binary(LTE, op, depth);   return;
+  case op_t::O_GT:  emit_binary(GT, op, depth);    return;
+  case op_t::O_GTE: emit_binary(GTE, op, depth);   return;
+  case op_t::O_ADD: emit_binary(ADD, op, depth);   return;
+  case op_t::O_SUB: emit_binary(SUB, op, depth);   return;
+  case op_t::O_MUL: emit_binary(MUL, op, depth);   return;
+  case op_t::O_DIV: emit_binary(DIV, op, depth);   return;
+  case op_t::O_MATCH: emit_binary(MATCH, op, depth); return;
+
+  case op_t::O_AND:
+  case op_t::O_OR: {
+    if (! op->left() || ! op->has_right())
+      break;
+    emit(op->left().get(), depth);
+    std::size_t jump = code.size();
+    code.push_back(instr_t(op->kind == op_t::O_AND ? AND_JUMP : OR_JUMP, op));
+    emit(op->right().get(), depth);
+    code[jump].target = code.size();
+    return;
+  }
+
+  case op_t::O_QUERY: {
+    if (! op->left() || ! op->has_right() ||
+        op->right()->kind != op_t::O_COLON ||
+        ! op->right()->left() || ! op->right()->has_right())
+      break;
+    emit(op->left().get(), depth);
+    std::size_t unless = code.size();
+    code.push_back(instr_t(JUMP_UNLESS, op));
+    emit(op->right()->left().get(), depth);
+    std::size_t jump = code.size();
+    code.push_back(instr_t(JUMP, op));
+    code[unless].target = code.size();
+    emit(op->right()->right().get(), depth);
+    code[jump].target = code.size();
+    return;
+  }
+
+  default:
+    break;
+  }
+
+  code.push_back(instr_t(EVALUATE, op));
+}
+
+void expr_t::program_t::emit_binary(opcode_t opcode, op_t * op,
+                                    std::size_t depth)
+{
+  if (! op->left() || ! op->has_right()) {
+    code.push_back(instr_t(EVALUATE, op));
+    return;
+  }
+  emit(op->left().get(), depth);
+  emit(op->right().get(), depth + 1);
+  code.push_back(instr_t(opcode, op));
+}
+
+bool expr_t::program_t::emit_accessor(op_t * op)
+{
+  const func_t& func(op->as_function());
+  instr_t       instr(CALL_FUNCTION, op);
+
+  if (const scope_accessor_t<post_t> * fn =
+      func.target<scope_accessor_t<post_t> >()) {
+    instr.code             = CALL_POST;
+    instr.accessor.post    = fn->accessor;
+  }
+  else if (const scope_accessor_t<item_t> * fn =
+           func.target<scope_accessor_t<item_t> >()) {
+    instr.code             = CALL_ITEM;
+    instr.accessor.item    = fn->accessor;
+  }
+  else if (const scope_accessor_t<xact_t> * fn =
+           func.target<scope_accessor_t<xact_t> >()) {
+    instr.code             = CALL_XACT;
+    instr.accessor.xact    = fn->accessor;
+  }
+  else if (const scope_accessor_t<account_t> * fn =
+           func.target<scope_accessor_t<account_t> >()) {
+    instr.code             = CALL_ACCOUNT;
+    instr.accessor.account = fn->accessor;
+  }
+  else {
+    return false;
+  }
+
+  code.push_back(instr);
+  return true;
+}
+
+namespace {
+  inline value_t call_function(expr_t::op_t * op, scope_t& scope,
+                               expr_t::ptr_op_t * locus)
+  {
+    call_scope_t call_args(scope, locus, 1);
+    return op->as_function()(call_args);
+  }
+}
+
+value_t expr_t::program_t::run(scope_t& scope, ptr_op_t * locus)
+{
+  boost::container::small_vector<value_t, 8> stack;
+  if (max_depth > stack.capacity())
+    stack.reserve(max_depth);
+
+  // The objects accessors apply to are searched for on first use only,
+  // since the scope does not change while the program runs.
+  item_t *    item    = NULL;
+  post_t *    post    = NULL;
+  xact_t *    xact    = NULL;
+  account_t * account = NULL;
+
+  std::size_t pc = 0;
+  try {
+    while (pc < code.size()) {
+      const instr_t& instr(code[pc]);
+      ++pc;
+
+      switch (instr.code) {
+      case PUSH_VALUE:
+        stack.push_back(instr.op->as_value());
+        break;
+
+      case CALL_FUNCTION:
+        stack.push_back(call_function(instr.op, scope, locus));
+        check_type_context(scope, stack.back());
+        break;
+
+      case CALL_ITEM:
+        if (item || (item = search_scope<item_t>(&scope)))
+          stack.push_back((*instr.accessor.item)(*item));
+        else
+          stack.push_back(call_function(instr.op, scope, locus));
+        check_type_context(scope, stack.back());
+        break;
+
+      case CALL_POST:
+        if (post || (post = search_scope<post_t>(&scope)))
+          stack.push_back((*instr.accessor.post)(*post));
+        else
+          stack.push_back(call_function(instr.op, scope, locus));
+        check_type_context(scope, stack.back());
+        break;
+
+      case CALL_XACT:
+        if (xact || (xact = search_scope<xact_t>(&scope)))
+          stack.push_back((*instr.accessor.xact)(*xact));
+        else
+          stack.push_back(call_function(instr.op, scope, locus));
+        check_type_context(scope, stack.back());
+        break;
+
+      case CALL_ACCOUNT:
+        if (account || (account = search_scope<account_t>(&scope)))
+          stack.push_back((*instr.accessor.account)(*account));
+        else
+          stack.push_back(call_function(instr.op, scope, locus));
+        check_type_context(scope, stack.back());
+        break;
+
+      case EVALUATE:
+        stack.push_back(instr.op->calc(scope, locus, 1));
+        break;
+
+      case NOT:
+        stack.back() = ! stack.back();
+        break;
+      case NEG:
+        stack.back().in_place_negate();
+        break;
+
+      case JUMP:
+        pc = instr.target;
+        break;
+      case JUMP_UNLESS: {
+        bool test = stack.back();
+        stack.pop_back();
+        if (! test)
+          pc = instr.target;
+        break;
+      }
+      case AND_JUMP:
+        if (! stack.back()) {
+          stack.back() = false;
+          pc = instr.target;
+        } else {
+          stack.pop_back();
+        }
+        break;
+      case OR_JUMP:
+        if (stack.back())
+          pc = instr.target;
+        else
+          stack.pop_back();
+        break;
+
+      default: {
+        value_t& lhs(stack[stack.size() - 2]);
+        value_t& rhs(stack.back());
+
+        switch (instr.code) {
+        case EQ:  lhs = (lhs == rhs); break;
+        case LT:  lhs = (lhs < rhs);  break;
+        case LTE: lhs = (lhs <= rhs); break;
+        case GT:  lhs = (lhs > rhs);  break;
+        case GTE: lhs = (lhs >= rhs); break;
+        case ADD: lhs += rhs;         break;
+        case SUB: lhs -= rhs;         break;
+        case MUL: lhs *= rhs;         break;
+        case DIV: lhs /= rhs;         break;
+        case MATCH:
+          lhs = rhs.as_mask().match(lhs.to_string());
+          break;
+        default:
+          assert(false);
+          break;
+        }
+        stack.pop_back();
+        break;
+      }
+      }
+    }
+  }
+  catch (const std::exception&) {
+    if (locus && ! *locus && pc > 0)
+      *locus = code[pc - 1].op;
+    throw;
+  }
+
+  assert(stack.size() == 1);
+  return stack.back();
+}
+
+} // namespace ledger
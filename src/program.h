@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2003-2018, John Wiegley.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * - Neither the name of New Artisans LLC nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup expr
+ */
+
+/**
+ * @file   program.h
+ * @author John Wiegley
+ *
+ * @ingroup expr
+ *
+ * @brief Flat instruction form of a compiled value expression.
+ *
+ * A compiled op_t tree is lowered into a linear array of instructions
+ * which is run by a small stack machine.  Constants, arithmetic,
+ * comparisons, logical operators and functions are handled directly;
+ * accessors created with scope_accessor_t are called on an item, post,
+ * xact or account which is searched for only once per evaluation.
+ * Every other node is evaluated by the ordinary tree walker.
+ */
+#ifndef _PROGRAM_H
+#define _PROGRAM_H
+
+#include "op.h"
+
+namespace ledger {
+
+class item_t;
+class post_t;
+class xact_t;
+class account_t;
+
+class expr_t::program_t : public noncopyable
+{
+public:
+  enum opcode_t {
+    PUSH_VALUE,                 // push op->as_value()
+    CALL_FUNCTION,              // call op->as_function()
+    CALL_ITEM,                  // apply accessor to the item in scope
+    CALL_POST,
+    CALL_XACT,
+    CALL_ACCOUNT,
+    EVALUATE,                   // op->calc() with the tree walker
+
+    NOT,
+    NEG,
+    EQ,
+    LT,
+    LTE,
+    GT,
+    GTE,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MATCH,
+
+    JUMP,                       // continue at target
+    JUMP_UNLESS,                // pop; continue at target if false
+    AND_JUMP,                   // if top is false, make it false and jump
+    OR_JUMP                     // if top is true, keep it and jump
+  };
+
+  struct instr_t
+  {
+    opcode_t    code;
+    op_t *      op;
+    std::size_t target;
+
+    union {
+      value_t (*item)(item_t&);
+      value_t (*post)(post_t&);
+      value_t (*xact)(xact_t&);
+      value_t (*account)(account_t&);
+    } accessor;
+
+    instr_t(opcode_t _code, op_t * _op)
+      : code(_code), op(_op), target(0) {
+      accessor.item = NULL;
+    }
+  };
+
+private:
+  ptr_op_t             root;
+  std::vector<instr_t> code;
+  std::size_t          max_depth;
+
+  explicit program_t(ptr_op_t _root);
+
+  void emit(op_t * op, std::size_t depth);
+  void emit_binary(opcode_t code, op_t * op, std::size_t depth);
+  bool emit_accessor(op_t * op);
+
+public:
+  ~program_t() {
+    TRACE_DTOR(program_t);
+  }
+
+  /**
+   * Lower the compiled tree rooted at op, or return NULL if the tree
+   * has nothing the tree walker would not do equally well.
+   */
+  static shared_ptr<program_t> lower(ptr_op_t op);
+
+  const ptr_op_t& get_root() const {
+    return root;
+  }
+  std::size_t size() const {
+    return code.size();
+  }
+
+  value_t run(scope_t& scope, ptr_op_t * locus = NULL);
+};
+
+} // namespace ledger
+
+#endif // _PROGRAM_H
@@ -46,29 +46,257 @@ namespace {
             acct.xdata().has_flags(ACCOUNT_EXT_VISITED)) ||
             acct.children_with_flags(ACCOUNT_EXT_VISITED));
   }
+
+  // The report is written one part at a time: a list of commodities, the
+  // account tree, and a list of transactions.  Each member of a list is
+  // put into a property tree of its own, written out, and then dropped,
+  // so that the whole report never has to be held in memory at once.
+  class ptree_writer : public noncopyable
+  {
+  protected:
+    std::ostream& out;
+    std::size_t   count;
+
+  public:
+    ptree_writer(std::ostream& _out) : out(_out), count(0) {}
+    virtual ~ptree_writer() {}
+
+    virtual void begin(const string& version) = 0;
+    virtual void begin_list(const string& name) = 0;
+    virtual void add(const string& name, const property_tree::ptree& pt) = 0;
+    virtual void end_list(const string& name) = 0;
+    virtual void end() = 0;
+  };
+
+  // Writes exactly what property_tree::write_xml would have written for
+  // the whole report, indenting by two spaces.
+  class xml_writer : public ptree_writer
+  {
+#if BOOST_VERSION >= 105600
+    typedef property_tree::xml_writer_settings<std::string> settings_t;
+#else
+    typedef property_tree::xml_writer_settings<char> settings_t;
+#endif
+
+    settings_t settings;
+    string     list_name;
+
+  public:
+    xml_writer(std::ostream& _out)
+      : ptree_writer(_out), settings(' ', 2) {}
+
+    virtual void begin(const string& version) {
+      out << "<?xml version=\"1.0\" encoding=\"" << settings.encoding
+          << "\"?>\n"
+          << "<ledger version=\"" << version << "\">\n";
+    }
+
+    virtual void begin_list(const string& name) {
+      count     = 0;
+      list_name = name;
+    }
+
+    virtual void add(const string& name, const property_tree::ptree& pt) {
+      if (count++ == 0)
+        out << "  <" << list_name << ">\n";
+      property_tree::xml_parser::write_xml_element(out, name, pt, 2, settings);
+    }
+
+    virtual void end_list(const string& name) {
+      if (count == 0)
+        out << "  <" << name << "/>\n";
+      else
+        out << "  </" << name << ">\n";
+    }
+
+    virtual void end() {
+      out << "</ledger>\n";
+    }
+  };
+
+  // Writes the same report as JSON.  Elements become objects, and their
+  // attributes and children become members.  Children that may repeat
+  // are gathered into arrays, as are the lists of the report itself.
+  class json_writer : public ptree_writer
+  {
+    void indent(int level) {
+      out << '\n' << string(static_cast<std::size_t>(level) * 2, ' ');
+    }
+
+    void write_string(const string& str) {
+      out << '"';
+      foreach (const char ch, str) {
+        switch (ch) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\b': out << "\\b"; break;
+        case '\f': out << "\\f"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(ch) < 0x20) {
+            std::ios::fmtflags flags(out.flags());
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                << static_cast<int>(ch);
+            out.flags(flags);
+            out.fill(' ');
+          } else {
+            out << ch;
+          }
+          break;
+        }
+      }
+      out << '"';
+    }
+
+    static bool repeats(const string& parent, const string& child) {
+      return (parent == "balance" || parent == "sequence" ||
+              parent == "metadata" || parent == "postings" ||
+              (parent == "account" && child == "account"));
+    }
+
+    void write_node(const string& name, const property_tree::ptree& pt,
+                    int level) {
+      if (pt.empty()) {
+        write_string(pt.data());
+        return;
+      }
+
+      out << '{';
+      bool first = true;
+
+      if (optional<const property_tree::ptree&> attrs =
+          pt.get_child_optional("<xmlattr>")) {
+        foreach (const property_tree::ptree::value_type& attr, *attrs) {
+          out << (first ? "" : ",");
+          first = false;
+          indent(level + 1);
+          write_string(attr.first);
+          out << ": ";
+          write_string(attr.second.data());
+        }
+      }
+
+      if (! pt.data().empty()) {
+        out << (first ? "" : ",");
+        first = false;
+        indent(level + 1);
+        out << "\"text\": ";
+        write_string(pt.data());
+      }
+
+      // Members are written in the order their names first appear.
+      std::list<string> names;
+      foreach (const property_tree::ptree::value_type& child, pt)
+        if (child.first != "<xmlattr>" &&
+            std::find(names.begin(), names.end(), child.first) == names.end())
+          names.push_back(child.first);
+
+      foreach (const string& child_name, names) {
+        out << (first ? "" : ",");
+        first = false;
+        indent(level + 1);
+        write_string(child_name);
+        out << ": ";
+
+        if (pt.count(child_name) > 1 || repeats(name, child_name)) {
+          out << '[';
+          bool first_member = true;
+          foreach (const property_tree::ptree::value_type& child, pt) {
+            if (child.first != child_name)
+              continue;
+            out << (first_member ? "" : ",");
+            first_member = false;
+            indent(level + 2);
+            write_node(child.first, child.second, level + 2);
+          }
+          indent(level + 1);
+          out << ']';
+        } else {
+          write_node(child_name, pt.get_child(child_name), level + 1);
+        }
+      }
+
+      indent(level);
+      out << '}';
+    }
+
+  public:
+    json_writer(std::ostream& _out) : ptree_writer(_out) {}
+
+    virtual void begin(const string& version) {
+      out << "{\n  \"ledger\": {\n    \"version\": ";
+      write_string(version);
+    }
+
+    virtual void begin_list(const string& name) {
+      count = 0;
+      out << ",\n    ";
+      write_string(name);
+      out << ": [";
+    }
+
+    virtual void add(const string& name, const property_tree::ptree& pt) {
+      // An account tree with nothing visited is left out of the list,
+      // rather than written as an empty string.
+      if (pt.empty() && pt.data().empty())
+        return;
+
+      out << (count++ == 0 ? "" : ",");
+      indent(3);
+      write_node(name, pt, 3);
+    }
+
+    virtual void end_list(const string&) {
+      if (count > 0)
+        indent(2);
+      out << ']';
+    }
+
+    virtual void end() {
+      out << "\n  }\n}\n";
+    }
+  };
 }
 
 void format_ptree::flush()
 {
   std::ostream& out(report.output_stream);
 
-  property_tree::ptree pt;
+  unique_ptr<ptree_writer> writer;
+  switch (format) {
+  case FORMAT_XML:
+    writer.reset(new xml_writer(out));
+    break;
+  case FORMAT_JSON:
+    writer.reset(new json_writer(out));
+    break;
+  }
 
-  pt.put("ledger.<xmlattr>.version",
-         lexical_cast<string>((Ledger_VERSION_MAJOR << 16) |
-                              (Ledger_VERSION_MINOR << 8) |
-                              Ledger_VERSION_PATCH));
+  writer->begin(lexical_cast<string>((Ledger_VERSION_MAJOR << 16) |
+                                     (Ledger_VERSION_MINOR << 8) |
+                                     Ledger_VERSION_PATCH));
 
-  property_tree::ptree& ct(pt.put("ledger.commodities", ""));
-  foreach (const commodities_pair& pair, commodities)
-    put_commodity(ct.add("commodity", ""), *pair.second, true);
+  writer->begin_list("commodities");
+  foreach (const commodities_pair& pair, commodities) {
+    property_tree::ptree ct;
+    put_commodity(ct, *pair.second, true);
+    writer->add("commodity", ct);
+  }
+  writer->end_list("commodities");
 
-  property_tree::ptree& at(pt.put("ledger.accounts", ""));
-  put_account(at.add("account", ""), *report.session.journal->master, account_visited_p);
+  writer->begin_list("accounts");
+  {
+    property_tree::ptree at;
+    put_account(at, *report.session.journal->master, account_visited_p);
+    writer->add("account", at);
+  }
+  writer->end_list("accounts");
 
-  property_tree::ptree& tt(pt.put("ledger.transactions", ""));
+  writer->begin_list("transactions");
   foreach (const xact_t * xact, transactions) {
-    property_tree::ptree& t(tt.add("transaction", ""));
+    property_tree::ptree t;
     put_xact(t, *xact);
 
     property_tree::ptree& post_tree(t.put("postings", ""));
@@ -76,20 +304,13 @@ void format_ptree::flush()
       if (post->has_xdata() &&
           post->xdata().has_flags(POST_EXT_VISITED))
         put_post(post_tree.add("posting", ""), *post);
-  }
-
-  switch (format) {
-  case FORMAT_XML:
-#if BOOST_VERSION >= 105600
-    auto indented = property_tree::xml_writer_make_settings<std::string> (' ', 2);
-#else
-    property_tree::xml_writer_settings<char> indented(' ', 2);
-#endif
 
-    property_tree::write_xml(out, pt, indented);
-    out << std::endl;
-    break;
+    writer->add("transaction", t);
   }
+  writer->end_list("transactions");
+
+  writer->end();
+  out << std::endl;
 }
 
 void format_ptree::operator()(post_t& post)
@@ -75,7 +75,8 @@ protected:
 
 public:
   enum format_t {
-    FORMAT_XML
+    FORMAT_XML,
+    FORMAT_JSON
   } format;
 
   format_ptree(report_t& _report, format_t _format = FORMAT_XML)
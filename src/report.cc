@@ -84,6 +84,8 @@ void report_t::normalize_options(const string& verb)
 
   commodity_pool_t::current_pool->keep_base  = HANDLED(base);
   commodity_pool_t::current_pool->get_quotes = session.HANDLED(download);
+  commodity_pool_t::current_pool->commodity_price_history.use_index
+    (! HANDLED(no_price_index));
 
   if (session.HANDLED(price_exp_))
     commodity_pool_t::current_pool->quote_leeway =
@@ -370,7 +372,13 @@ void report_t::generate_report(post_handler_ptr handler)
     (session, HANDLED(seed_) ?
      lexical_cast<unsigned int>(HANDLER(seed_).str()) : 0,
      HANDLED(head_) ?
-     lexical_cast<unsigned int>(HANDLER(head_).str()) : 50);
+     lexical_cast<unsigned int>(HANDLER(head_).str()) : 50,
+     HANDLED(generate_accounts_) ?
+     lexical_cast<std::size_t>(HANDLER(generate_accounts_).str()) : 0,
+     HANDLED(generate_commodities_) ?
+     lexical_cast<std::size_t>(HANDLER(generate_commodities_).str()) : 0,
+     HANDLED(generate_prices_) ?
+     lexical_cast<int>(HANDLER(generate_prices_).str()) : -1);
 
   pass_down_posts<generate_posts_iterator>(handler, walker);
 }
@@ -1016,8 +1024,12 @@ namespace {
 
 value_t report_t::reload_command(call_scope_t&)
 {
-  session.close_journal_files();
-  session.read_journal_files();
+  // Journal files are most often only appended to, in which case there
+  // is no need to read them again from the start.
+  if (! session.read_appended_data()) {
+    session.close_journal_files();
+    session.read_journal_files();
+  }
   return true;
 }
 
@@ -1184,6 +1196,9 @@ option_t<report_t> * report_t::lookup_option(const char * p)
     OPT(gain);
     else OPT(group_by_);
     else OPT(group_title_format_);
+    else OPT(generate_accounts_);
+    else OPT(generate_commodities_);
+    else OPT(generate_prices_);
     else OPT(generated);
     break;
   case 'h':
@@ -1217,6 +1232,7 @@ option_t<report_t> * report_t::lookup_option(const char * p)
     OPT_CH(collapse);
     else OPT(no_color);
     else OPT(no_pager);
+    else OPT(no_price_index);
     else OPT(no_revalued);
     else OPT(no_rounding);
     else OPT(no_titles);
@@ -1271,6 +1287,7 @@ option_t<report_t> * report_t::lookup_option(const char * p)
   case 't':
     OPT_CH(amount_);
     else OPT(tail_);
+    else OPT(threads_);
     else OPT(total_);
     else OPT(total_data);
     else OPT(truncate_);
@@ -1659,6 +1676,12 @@ expr_t::ptr_op_t report_t::lookup(const symbol_t::kind_t kind,
       }
       break;
 
+    case 'j':
+      if (is_eq(p, "json"))
+        return POSTS_REPORTER(new format_ptree(*this,
+                                               format_ptree::FORMAT_JSON));
+      break;
+
     case 'l':
       if (is_eq(p, "lisp"))
         return POSTS_REPORTER(new format_emacs_posts(output_stream));
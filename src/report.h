@@ -287,6 +287,9 @@ public:
     HANDLER(forecast_years_).report(out);
     HANDLER(format_).report(out);
     HANDLER(gain).report(out);
+    HANDLER(generate_accounts_).report(out);
+    HANDLER(generate_commodities_).report(out);
+    HANDLER(generate_prices_).report(out);
     HANDLER(generated).report(out);
     HANDLER(group_by_).report(out);
     HANDLER(group_title_format_).report(out);
@@ -304,6 +307,7 @@ public:
     HANDLER(meta_).report(out);
     HANDLER(monthly).report(out);
     HANDLER(no_pager).report(out);
+    HANDLER(no_price_index).report(out);
     HANDLER(no_rounding).report(out);
     HANDLER(no_titles).report(out);
     HANDLER(no_total).report(out);
@@ -342,6 +346,7 @@ public:
     HANDLER(start_of_week_).report(out);
     HANDLER(subtotal).report(out);
     HANDLER(tail_).report(out);
+    HANDLER(threads_).report(out);
     HANDLER(time_report).report(out);
     HANDLER(total_).report(out);
     HANDLER(total_data).report(out);
@@ -703,6 +708,9 @@ public:
             " - get_at(total_expr, 1)");
     });
 
+  OPTION(report_t, generate_accounts_);
+  OPTION(report_t, generate_commodities_);
+  OPTION(report_t, generate_prices_);
   OPTION(report_t, generated);
 
   OPTION_
@@ -770,6 +778,7 @@ public:
       OTHER(revalued).off();
     });
 
+  OPTION(report_t, no_price_index);
   OPTION(report_t, no_rounding);
   OPTION(report_t, no_titles);
   OPTION(report_t, no_total);
@@ -973,6 +982,12 @@ public:
   OPTION(report_t, subtotal); // -s
   OPTION(report_t, tail_);
 
+  OPTION_(report_t, threads_, DO_(str) {
+      if (lexical_cast<int>(str) < 1)
+        throw_(std::invalid_argument,
+               _f("Invalid number of threads '%1%'") % str);
+    });
+
   OPTION_(report_t, time_report, DO() {
       OTHER(balance_format_)
         .on(none,
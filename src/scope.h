@@ -581,6 +581,26 @@ inline string join_args(call_scope_t& args) {
   return buf.str();
 }
 
+/**
+ * An expression function which applies a plain accessor to the nearest
+ * object of type T in the calling scope.  Because the accessor is kept
+ * visible, compiled expression programs can recognize these functions
+ * and call the accessor directly, searching for the object only once.
+ */
+template <typename T>
+struct scope_accessor_t
+{
+  typedef value_t (*accessor_t)(T&);
+
+  accessor_t accessor;
+
+  explicit scope_accessor_t(accessor_t _accessor) : accessor(_accessor) {}
+
+  value_t operator()(call_scope_t& args) const {
+    return (*accessor)(find_scope<T>(args));
+  }
+};
+
 class value_scope_t : public child_scope_t
 {
   value_t value;
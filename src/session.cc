@@ -32,6 +32,7 @@
 #include <system.hh>
 
 #include "session.h"
+#include "archive.h"
 #include "xact.h"
 #include "account.h"
 #include "journal.h"
@@ -59,7 +60,8 @@ void set_session_context(session_t * session)
 }
 
 session_t::session_t()
-  : flush_on_next_data_file(false), journal(new journal_t)
+  : flush_on_next_data_file(false), reloadable(false),
+    journal(new journal_t)
 {
  parsing_context.push();
 
@@ -108,6 +110,10 @@ std::size_t session_t::read_data(const string& master_account)
   if (HANDLED(day_break))
     journal->day_break = true;
 
+  // Only a session that lives on to run reload needs to know whether its
+  // files were merely appended to.
+  journal->reloadable = reloadable;
+
   if (HANDLED(recursive_aliases))
     journal->recursive_aliases = true;
   if (HANDLED(no_aliases))
@@ -128,6 +134,53 @@ std::size_t session_t::read_data(const string& master_account)
   if (HANDLED(value_expr_))
     journal->value_expr = HANDLER(value_expr_).str();
 
+  unique_ptr<archive_t> cache;
+  if (HANDLED(cache_)) {
+    // The initialization file, if any, has been read by now, but it is
+    // read again every time, so it does not stop the data files from
+    // being cached.
+    journal->cacheable = true;
+
+    // The cache is keyed on everything besides the files themselves that
+    // affects how they are parsed: the options given, which files were
+    // named, and the current date, since a date without a year is placed
+    // in the current year or, if its month is still to come, the last.
+    std::ostringstream key;
+    key << Ledger_VERSION_MAJOR << '.' << Ledger_VERSION_MINOR << '.'
+        << Ledger_VERSION_PATCH << Ledger_VERSION_PRERELEASE << ' '
+        << Ledger_VERSION_DATE << '\n';
+    report_options(key);
+    key << master_account << '\n'
+        << format_date(CURRENT_DATE(), FMT_WRITTEN) << '\n';
+    if (price_db_path && exists(*price_db_path))
+      key << *price_db_path << '\n';
+
+    try {
+      foreach (const path& pathname, HANDLER(file_).data_files) {
+        if (pathname == "-" || pathname == "/dev/stdin")
+          throw_(std::runtime_error, _("Standard input cannot be cached"));
+        key << journal_path_for_reading(pathname, filesystem::current_path())
+            << '\n';
+      }
+      cache.reset(new archive_t(resolve_path(HANDLER(cache_).str()),
+                                key.str()));
+    }
+    catch (...) {
+      // Any errors are reported when the files are parsed.
+    }
+
+    if (cache && cache->should_load()) {
+      cache->load(*journal);
+
+      if (populated_data_files)
+        HANDLER(file_).data_files.clear();
+
+      VERIFY(journal->valid());
+
+      return journal->xacts.size();
+    }
+  }
+
   if (price_db_path) {
     if (exists(*price_db_path)) {
       parsing_context.push(*price_db_path);
@@ -181,6 +234,9 @@ std::size_t session_t::read_data(const string& master_account)
         << "] == journal->xacts.size() [" << journal->xacts.size() << "]");
   assert(xact_count == journal->xacts.size());
 
+  if (cache && cache->should_save(*journal))
+    cache->save(*journal);
+
   if (populated_data_files)
     HANDLER(file_).data_files.clear();
 
@@ -211,6 +267,24 @@ journal_t * session_t::read_journal_files()
   return journal.get();
 }
 
+bool session_t::read_appended_data()
+{
+  account_t * acct = journal->master;
+  if (HANDLED(master_account_))
+    acct = journal->find_account(HANDLER(master_account_).str());
+
+  INFO_START(journal, "Read appended journal data");
+
+  bool appended = journal->read_appended(parsing_context, acct);
+
+  INFO_FINISH(journal);
+
+  if (appended)
+    VERIFY(journal->valid());
+
+  return appended;
+}
+
 journal_t * session_t::read_journal(const path& pathname)
 {
   HANDLER(file_).data_files.clear();
@@ -317,7 +391,8 @@ option_t<session_t> * session_t::lookup_option(const char * p)
     OPT_CH(price_exp_);
     break;
   case 'c':
-    OPT(check_payees);
+    OPT(cache_);
+    else OPT(check_payees);
     break;
   case 'd':
     OPT(download); // -Q
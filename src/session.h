@@ -68,6 +68,7 @@ class session_t : public symbol_scope_t
 
 public:
   bool flush_on_next_data_file;
+  bool reloadable;
 
   unique_ptr<journal_t> journal;
   parse_context_stack_t parsing_context;
@@ -86,12 +87,16 @@ public:
   void set_flush_on_next_data_file(const bool truth) {
     flush_on_next_data_file = truth;
   }
+  void set_reloadable(const bool truth) {
+    reloadable = truth;
+  }
 
   journal_t * read_journal(const path& pathname);
   journal_t * read_journal_from_string(const string& data);
   std::size_t read_data(const string& master_account = "");
 
   journal_t * read_journal_files();
+  bool read_appended_data();
   void close_journal_files();
 
   journal_t * get_journal();
@@ -107,6 +112,7 @@ public:
 
   void report_options(std::ostream& out)
   {
+    HANDLER(cache_).report(out);
     HANDLER(check_payees).report(out);
     HANDLER(day_break).report(out);
     HANDLER(download).report(out);
@@ -135,6 +141,7 @@ public:
    * Option handlers
    */
 
+  OPTION(session_t, cache_);
   OPTION(session_t, check_payees);
   OPTION(session_t, day_break);
   OPTION(session_t, download); // -Q
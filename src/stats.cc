@@ -37,6 +37,7 @@
 #include "account.h"
 #include "report.h"
 #include "session.h"
+#include "pool.h"
 
 namespace ledger {
 
@@ -111,6 +112,16 @@ value_t report_statistics(call_scope_t& args)
   out.width(6);
   out << statistics.posts_this_month_count << std::endl;
 
+  const commodity_pool_t& pool(*commodity_pool_t::current_pool);
+  if (std::size_t lookups = pool.price_lookups) {
+    out << std::endl;
+
+    out << _("  Price lookups:          ");
+    out.width(6);
+    out << lookups << " (" << pool.price_lookups_cached
+        << _(" remembered)") << std::endl;
+  }
+
   out.flush();
 
   return NULL_VALUE;
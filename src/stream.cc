@@ -36,6 +36,18 @@
 namespace ledger {
 
 namespace {
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+  std::ostream * fd_ostream(int fd)
+  {
+    typedef iostreams::stream<iostreams::file_descriptor_sink> fdstream;
+#if BOOST_VERSION >= 104400
+    return new fdstream(fd, iostreams::never_close_handle);
+#else // BOOST_VERSION >= 104400
+    return new fdstream(fd);
+#endif // BOOST_VERSION >= 104400
+  }
+#endif
+
   /**
    * @brief Forks a child process so that Ledger may handle running a
    * pager
@@ -88,12 +100,7 @@ namespace {
     }
     else {                      // parent
       close(pfd[0]);
-      typedef iostreams::stream<iostreams::file_descriptor_sink> fdstream;
-#if BOOST_VERSION >= 104400
-      *os = new fdstream(pfd[1], iostreams::never_close_handle);
-#else // BOOST_VERSION >= 104400
-      *os = new fdstream(pfd[1]);
-#endif // BOOST_VERSION >= 104400
+      *os = fd_ostream(pfd[1]);
     }
     return pfd[1];
 #else
@@ -113,6 +120,15 @@ void output_stream_t::initialize(const optional<path>& output_file,
     os = &std::cout;
 }
 
+void output_stream_t::initialize(int fd)
+{
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+  os = fd_ostream(fd);
+#else
+  throw std::logic_error(_("Writing to a file descriptor is not supported"));
+#endif
+}
+
 void output_stream_t::close()
 {
 #if !defined(_WIN32) && !defined(__CYGWIN__)
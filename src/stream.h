@@ -116,6 +116,15 @@ public:
   void initialize(const optional<path>& output_file = none,
                   const optional<path>& pager_path  = none);
 
+  /**
+   * Initialize the output stream object to write to an open file
+   * descriptor, such as a client's connection to a server.  The
+   * descriptor is left open when the stream is closed.
+   *
+   * @param fd File descriptor to which to send output.
+   */
+  void initialize(int fd);
+
   /**
    * Convertor to a standard ostream.  This is used so that we can
    * stream directly to an object of type output_stream_t.
@@ -78,6 +78,7 @@ namespace {
     instance_t *             parent;
     std::list<application_t> apply_stack;
     bool                     no_assertions;
+    bool                     open_comment;
 #if defined(TIMELOG_SUPPORT)
     time_log_t               timelog;
 #endif
@@ -88,7 +89,8 @@ namespace {
                const bool             _no_assertions = false)
       : context_stack(_context_stack), context(_context),
         in(*context.stream.get()), parent(_parent),
-        no_assertions(_no_assertions), timelog(context) {}
+        no_assertions(_no_assertions), open_comment(false),
+        timelog(context) {}
 
     virtual string description() {
       return _("textual parser");
@@ -120,6 +122,17 @@ namespace {
         return NULL;
     }
 
+    // True if nothing is open at this point, in this file or in those
+    // including it, so that reading from here on would go the same if it
+    // began afresh.
+    bool at_top_level() const {
+      return (apply_stack.size() == 1 && ! open_comment &&
+#if defined(TIMELOG_SUPPORT)
+              timelog.empty() &&
+#endif
+              (! parent || parent->at_top_level()));
+    }
+
     void parse();
 
     std::streamsize read_line(char *& line);
@@ -242,7 +255,8 @@ void instance_t::parse()
   if (! in.good() || in.eof())
     return;
 
-  context.linenum  = 0;
+  // The line number is not reset here, since reading may begin in the
+  // middle of a file that was only appended to since it was last read.
   context.curr_pos = in.tellg();
 
   bool error_flag = false;
@@ -285,6 +299,8 @@ void instance_t::parse()
     }
   }
 
+  context.resumable = at_top_level();
+
   if (apply_stack.front().value.type() == typeid(optional<datetime_t>))
     epoch = boost::get<optional<datetime_t> >(apply_stack.front().value);
 
@@ -341,6 +357,9 @@ void instance_t::read_next_directive(bool& error_flag)
   if (! std::isspace(line[0]))
     error_flag = false;
 
+  if (! std::strchr(";#*|", line[0]))
+    context.journal->directives++;
+
   switch (line[0]) {
   case '\0':
     assert(false);              // shouldn't ever reach here
@@ -539,6 +558,10 @@ void instance_t::nomarket_directive(char * line)
 
 void instance_t::option_directive(char * line)
 {
+  // Options change the session, not the journal, so they would be lost
+  // if the journal were later read back from a cache.
+  context.journal->cacheable = false;
+
   char * p = next_element(line);
   if (! p) {
     p = std::strchr(line, '=');
@@ -568,6 +591,8 @@ void instance_t::automated_xact_directive(char * line)
     }
 
     unique_ptr<auto_xact_t> ae(new auto_xact_t(predicate_t(expr, keeper)));
+    // Keep the query text, so the predicate can be rebuilt from a cache.
+    ae->predicate.set_text(skip_ws(line + 1));
     ae->pos           = position_t();
     ae->pos->pathname = context.pathname;
     ae->pos->beg_pos  = context.line_beg_pos;
@@ -751,6 +776,11 @@ void instance_t::include_directive(char * line)
   glob.assign_glob('^' + filename.leaf() + '$');
 #endif // BOOST_VERSION >= 103700
 
+  // The set of files matched by a wildcard can change without any of
+  // the files themselves changing, so such journals are never cached.
+  if (std::strpbrk(line, "*?[") != NULL)
+    context.journal->cacheable = false;
+
   bool files_found = false;
   if (exists(parent_path)) {
     filesystem::directory_iterator end;
@@ -807,6 +837,8 @@ void instance_t::include_directive(char * line)
           count    += context_stack.get_current().count;
           sequence += context_stack.get_current().sequence;
 
+          journal->add_source(context_stack.get_current());
+
           context_stack.pop();
 
           files_found = true;
@@ -970,6 +1002,7 @@ void instance_t::account_directive(char * line)
       // jww (2012-02-27): Make account into symbol scopes so that this
       // can be used to override definitions within the account.
       bind_scope_t bound_scope(*context.scope, *account);
+      context.journal->cacheable = false;
       expr_t(b).calc(bound_scope);
     }
     else if (keyword == "note") {
@@ -1004,6 +1037,8 @@ void instance_t::account_alias_directive(account_t * account, string alias)
       (accounts_map::value_type(alias, account));
   if (! result.second)
     (*result.first).second = account;
+
+  context.journal->alias_index.clear();
 }
 
 void instance_t::alias_directive(char * line)
@@ -1168,12 +1203,16 @@ void instance_t::tag_directive(char * line)
 
 void instance_t::eval_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   expr_t expr(line);
   expr.calc(*context.scope);
 }
 
 void instance_t::assert_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   expr_t expr(line);
   if (! expr.calc(*context.scope).to_boolean())
     throw_(parse_error, _f("Assertion failed: %1%") % line);
@@ -1181,6 +1220,8 @@ void instance_t::assert_directive(char * line)
 
 void instance_t::check_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   expr_t expr(line);
   if (! expr.calc(*context.scope).to_boolean())
     context.warning(_f("Check failed: %1%") % line);
@@ -1197,15 +1238,18 @@ void instance_t::comment_directive(char * line)
     if (read_line(line) > 0) {
       std::string buf(line);
       if (starts_with(buf, "end comment") || starts_with(buf, "end test"))
-        break;
+        return;
     }
   }
+  open_comment = true;
 }
 
 #if HAVE_BOOST_PYTHON
 
 void instance_t::import_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   string module_name(line);
   trim(module_name);
   python_session->import_option(module_name);
@@ -1213,6 +1257,8 @@ void instance_t::import_directive(char * line)
 
 void instance_t::python_directive(char * line)
 {
+  context.journal->cacheable = false;
+
   std::ostringstream script;
 
   if (line)
@@ -1396,6 +1442,8 @@ bool instance_t::general_directive(char * line)
   }
 
   if (expr_t::ptr_op_t op = lookup(symbol_t::DIRECTIVE, p)) {
+    context.journal->cacheable = false;
+
     call_scope_t args(*this);
     args.push_back(string_value(p));
     op->as_function()(args);
@@ -1413,7 +1461,7 @@ post_t * instance_t::parse_post(char *          line,
 {
   TRACE_START(post_details, 1, "Time spent parsing postings:");
 
-  unique_ptr<post_t> post(new post_t);
+  unique_ptr<post_t> post(new (context.journal->arena) post_t);
 
   post->xact          = xact;   // this could be NULL
   post->pos           = position_t();
@@ -1496,14 +1544,25 @@ post_t * instance_t::parse_post(char *          line,
 
   if (next && *next && (*next != ';' && *next != '=')) {
     beg = static_cast<std::streamsize>(next - line);
-    ptristream stream(next, static_cast<std::size_t>(len - beg));
 
-    if (*next != '(')           // indicates a value expression
-      post->amount.parse(stream, PARSE_NO_REDUCE);
-    else
+    // A plain amount is read straight from the line; only a value
+    // expression needs a stream.
+    std::size_t consumed = 0;
+    bool        at_end   = false;
+
+    if (*next != '(') {
+      post->amount.parse(next, static_cast<std::size_t>(len - beg), consumed,
+                         PARSE_NO_REDUCE);
+    } else {
+      ptristream stream(next, static_cast<std::size_t>(len - beg));
       parse_amount_expr(stream, *context.scope, *post.get(), post->amount,
                         PARSE_NO_REDUCE | PARSE_SINGLE | PARSE_NO_ASSIGN,
                         defer_expr, &post->amount_expr);
+      if (stream.eof())
+        at_end = true;
+      else
+        consumed = static_cast<std::size_t>(stream.tellg());
+    }
 
     DEBUG("textual.parse", "line " << context.linenum << ": "
           << "post amount = " << post->amount);
@@ -1527,10 +1586,10 @@ post_t * instance_t::parse_post(char *          line,
       }
     }
 
-    if (stream.eof()) {
+    if (at_end) {
       next = NULL;
     } else {
-      next = skip_ws(next + static_cast<std::ptrdiff_t>(stream.tellg()));
+      next = skip_ws(next + static_cast<std::ptrdiff_t>(consumed));
 
       // Parse the optional cost (@ PER-UNIT-COST, @@ TOTAL-COST)
 
@@ -1568,13 +1627,22 @@ post_t * instance_t::parse_post(char *          line,
           }
 
           beg = static_cast<std::streamsize>(p - line);
-          ptristream cstream(p, static_cast<std::size_t>(len - beg));
 
-          if (*p != '(')                // indicates a value expression
-            post->cost->parse(cstream, PARSE_NO_MIGRATE);
-          else
+          std::size_t consumed = 0;
+          bool        at_end   = false;
+
+          if (*p != '(') {              // indicates a value expression
+            post->cost->parse(p, static_cast<std::size_t>(len - beg),
+                              consumed, PARSE_NO_MIGRATE);
+          } else {
+            ptristream cstream(p, static_cast<std::size_t>(len - beg));
             parse_amount_expr(cstream, *context.scope, *post.get(), *post->cost,
                               PARSE_NO_MIGRATE | PARSE_SINGLE | PARSE_NO_ASSIGN);
+            if (cstream.eof())
+              at_end = true;
+            else
+              consumed = static_cast<std::size_t>(cstream.tellg());
+          }
 
           if (post->cost->sign() < 0)
             throw parse_error(_("A posting's cost may not be negative"));
@@ -1603,10 +1671,10 @@ post_t * instance_t::parse_post(char *          line,
           DEBUG("textual.parse", "line " << context.linenum << ": "
                 << "Annotated amount is " << post->amount);
 
-          if (cstream.eof())
+          if (at_end)
             next = NULL;
           else
-            next = skip_ws(p + static_cast<std::ptrdiff_t>(cstream.tellg()));
+            next = skip_ws(p + static_cast<std::ptrdiff_t>(consumed));
         } else {
           throw parse_error(_("Expected a cost amount"));
         }
@@ -1627,14 +1695,23 @@ post_t * instance_t::parse_post(char *          line,
       post->assigned_amount = amount_t();
 
       beg = static_cast<std::streamsize>(p - line);
-      ptristream stream(p, static_cast<std::size_t>(len - beg));
 
-      if (*p != '(')            // indicates a value expression
-        post->assigned_amount->parse(stream, PARSE_NO_MIGRATE);
-      else
+      std::size_t consumed = 0;
+      bool        at_end   = false;
+
+      if (*p != '(') {          // indicates a value expression
+        post->assigned_amount->parse(p, static_cast<std::size_t>(len - beg),
+                                     consumed, PARSE_NO_MIGRATE);
+      } else {
+        ptristream stream(p, static_cast<std::size_t>(len - beg));
         parse_amount_expr(stream, *context.scope, *post.get(),
                           *post->assigned_amount,
                           PARSE_SINGLE | PARSE_NO_MIGRATE);
+        if (stream.eof())
+          at_end = true;
+        else
+          consumed = static_cast<std::size_t>(stream.tellg());
+      }
 
       if (post->assigned_amount->is_null()) {
         if (post->amount.is_null())
@@ -1706,10 +1783,10 @@ post_t * instance_t::parse_post(char *          line,
         }
       }
 
-      if (stream.eof())
+      if (at_end)
         next = NULL;
       else
-        next = skip_ws(p + static_cast<std::ptrdiff_t>(stream.tellg()));
+        next = skip_ws(p + static_cast<std::ptrdiff_t>(consumed));
     } else {
       throw parse_error(_("Expected an balance assignment/assertion amount"));
     }
@@ -1783,7 +1860,7 @@ xact_t * instance_t::parse_xact(char *          line,
 {
   TRACE_START(xact_text, 1, "Time spent parsing transaction text:");
 
-  unique_ptr<xact_t> xact(new xact_t);
+  unique_ptr<xact_t> xact(new (context.journal->arena) xact_t);
 
   xact->pos           = position_t();
   xact->pos->pathname = context.pathname;
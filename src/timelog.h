@@ -100,6 +100,10 @@ public:
     TRACE_DTOR(time_log_t);
   }
 
+  bool empty() const {
+    return time_xacts.empty();
+  }
+
   void clock_in(time_xact_t event);
   std::size_t clock_out(time_xact_t event);
 
@@ -249,8 +249,88 @@ namespace {
     return when;
   }
 
+  // Parse the usual YYYY/MM/DD and MM/DD forms, with any of '/', '-' or
+  // '.' between the fields, without going through strptime.  Anything
+  // else, including values strptime would reject, is left to the readers
+  // so that it fails (or succeeds) exactly as before.
+  bool parse_date_quickly(const char * p, date_t& when, date_traits_t& traits)
+  {
+    int fields[3];
+    int digits[3];
+    int count = 0;
+
+    while (true) {
+      if (count == 3)
+        return false;
+
+      int value = 0;
+      int len   = 0;
+      for (; *p >= '0' && *p <= '9' && len < 5; p++, len++)
+        value = value * 10 + (*p - '0');
+      if (len == 0)
+        return false;
+
+      fields[count] = value;
+      digits[count] = len;
+      count++;
+
+      if (*p == '\0')
+        break;
+      if (*p != '/' && *p != '-' && *p != '.')
+        return false;
+      p++;
+    }
+
+    int year;
+    int month;
+    int day;
+    if (count == 3) {
+      if (digits[0] != 4 || fields[0] < 1000 ||
+          digits[1] > 2 || digits[2] > 2)
+        return false;
+      year   = fields[0];
+      month  = fields[1];
+      day    = fields[2];
+      traits = date_traits_t(true, true, true);
+    }
+    else if (count == 2) {
+      if (digits[0] > 2 || digits[1] > 2)
+        return false;
+      year   = CURRENT_DATE().year();
+      month  = fields[0];
+      day    = fields[1];
+      traits = date_traits_t(false, true, true);
+    }
+    else {
+      return false;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > 31)
+      return false;
+
+    when = date_t(static_cast<date_t::year_type>(year),
+                  static_cast<date_t::month_type>(month),
+                  static_cast<date_t::day_type>(day));
+
+    if (! traits.has_year && when.month() > CURRENT_DATE().month())
+      when -= gregorian::years(1);
+
+    return true;
+  }
+
   date_t parse_date_mask(const char * date_str, date_traits_t * traits = NULL)
   {
+    // The default readers (with no --input-date-format) accept these.
+    if (convert_separators_to_slashes && ! input_date_io.get()) {
+      date_t        when;
+      date_traits_t quick_traits;
+      if (parse_date_quickly(date_str, when, quick_traits)) {
+        if (traits)
+          *traits = quick_traits;
+        return when;
+      }
+    }
+
     if (input_date_io.get()) {
       date_t when = parse_date_mask_routine(date_str, *input_date_io.get(),
                                             traits);
@@ -2044,27 +2044,36 @@ bool value_t::valid() const
   return true;
 }
 
-bool sort_value_is_less_than(const std::list<sort_value_t>& left_values,
-                             const std::list<sort_value_t>& right_values)
-{
-  std::list<sort_value_t>::const_iterator left_iter  = left_values.begin();
-  std::list<sort_value_t>::const_iterator right_iter = right_values.begin();
-
-  while (left_iter != left_values.end() && right_iter != right_values.end()) {
+namespace {
+  // Returns -1, 0 or 1 if LEFT sorts before, with or after RIGHT.
+  int compare_sort_values(const sort_value_t& left, const sort_value_t& right)
+  {
     // Don't even try to sort balance values
-    if (! (*left_iter).value.is_balance() &&
-        ! (*right_iter).value.is_balance()) {
+    if (! left.value.is_balance() && ! right.value.is_balance()) {
       DEBUG("value.sort",
-            " Comparing " << (*left_iter).value << " < " << (*right_iter).value);
-      if ((*left_iter).value < (*right_iter).value) {
+            " Comparing " << left.value << " < " << right.value);
+      if (left.value < right.value) {
         DEBUG("value.sort", "  is less");
-        return ! (*left_iter).inverted;
+        return left.inverted ? 1 : -1;
       }
-      else if ((*left_iter).value > (*right_iter).value) {
+      else if (left.value > right.value) {
         DEBUG("value.sort", "  is greater");
-        return (*left_iter).inverted;
+        return left.inverted ? -1 : 1;
       }
     }
+    return 0;
+  }
+}
+
+bool sort_value_is_less_than(const std::list<sort_value_t>& left_values,
+                             const std::list<sort_value_t>& right_values)
+{
+  std::list<sort_value_t>::const_iterator left_iter  = left_values.begin();
+  std::list<sort_value_t>::const_iterator right_iter = right_values.begin();
+
+  while (left_iter != left_values.end() && right_iter != right_values.end()) {
+    if (int result = compare_sort_values(*left_iter, *right_iter))
+      return result < 0;
     left_iter++; right_iter++;
   }
 
@@ -2074,6 +2083,17 @@ bool sort_value_is_less_than(const std::list<sort_value_t>& left_values,
   return false;
 }
 
+bool sort_value_is_less_than(const sort_value_t * left_values,
+                             const sort_value_t * right_values,
+                             std::size_t          count)
+{
+  for (std::size_t i = 0; i < count; i++)
+    if (int result = compare_sort_values(left_values[i], right_values[i]))
+      return result < 0;
+
+  return false;
+}
+
 void put_value(property_tree::ptree& pt, const value_t& value)
 {
   switch (value.type()) {
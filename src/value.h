@@ -143,9 +143,10 @@ public:
 
     /**
      * `refc' holds the current reference count for each storage_t
-     * object.
+     * object.  It is atomic because storage may be shared between
+     * values in different threads, such as `true_value' below.
      */
-    mutable int refc;
+    mutable std::atomic<int> refc;
 
     /**
      * Constructor.  Since all storage object are assigned to after
@@ -1001,6 +1002,9 @@ struct sort_value_t
 
 bool sort_value_is_less_than(const std::list<sort_value_t>& left_values,
                              const std::list<sort_value_t>& right_values);
+bool sort_value_is_less_than(const sort_value_t * left_values,
+                             const sort_value_t * right_values,
+                             std::size_t          count);
 
 void put_value(property_tree::ptree& pt, const value_t& value);
 
@@ -497,8 +497,8 @@ namespace {
   }
 
   template <value_t (*Func)(xact_t&)>
-  value_t get_wrapper(call_scope_t& scope) {
-    return (*Func)(find_scope<xact_t>(scope));
+  scope_accessor_t<xact_t> get_wrapper() {
+    return scope_accessor_t<xact_t>(Func);
   }
 
   value_t fn_any(call_scope_t& args)
@@ -544,17 +544,17 @@ expr_t::ptr_op_t xact_t::lookup(const symbol_t::kind_t kind,
 
   case 'c':
     if (name == "code")
-      return WRAP_FUNCTOR(get_wrapper<&get_code>);
+      return WRAP_FUNCTOR(get_wrapper<&get_code>());
     break;
 
   case 'm':
     if (name == "magnitude")
-      return WRAP_FUNCTOR(get_wrapper<&get_magnitude>);
+      return WRAP_FUNCTOR(get_wrapper<&get_magnitude>());
     break;
 
   case 'p':
     if (name[1] == '\0' || name == "payee")
-      return WRAP_FUNCTOR(get_wrapper<&get_payee>);
+      return WRAP_FUNCTOR(get_wrapper<&get_payee>());
     break;
   }
 
@@ -633,6 +633,150 @@ static string apply_format(const string& str, scope_t& scope)
   }
 }
 
+bool auto_xact_t::quick_match(post_t& post)
+{
+  return post_pred(predicate.get_op(), post);
+}
+
+bool auto_xact_t::apply_to_post(xact_base_t& xact, post_t& initial_post,
+                                parse_context_t& context)
+{
+  bind_scope_t bound_scope(*scope_t::default_scope, initial_post);
+
+  bool needs_further_verification = false;
+
+  if (deferred_notes) {
+    foreach (deferred_tag_data_t& data, *deferred_notes) {
+      if (data.apply_to_post == NULL)
+        initial_post.append_note(
+          apply_format(data.tag_data, bound_scope).c_str(),
+          bound_scope, data.overwrite_existing);
+    }
+  }
+
+  if (check_exprs) {
+    foreach (expr_t::check_expr_pair& pair, *check_exprs) {
+      if (pair.second == expr_t::EXPR_GENERAL) {
+        pair.first.calc(bound_scope);
+      }
+      else if (! pair.first.calc(bound_scope).to_boolean()) {
+        if (pair.second == expr_t::EXPR_ASSERTION)
+          throw_(parse_error,
+                 _f("Transaction assertion failed: %1%") % pair.first);
+        else
+          context.warning(_f("Transaction check failed: %1%") % pair.first);
+      }
+    }
+  }
+
+  foreach (post_t * post, posts) {
+    amount_t post_amount;
+    if (post->amount.is_null()) {
+      if (! post->amount_expr)
+        throw_(amount_error,
+               _("Automated transaction's posting has no amount"));
+
+      value_t result(post->amount_expr->calc(bound_scope));
+      if (result.is_long()) {
+        post_amount = result.to_amount();
+      } else {
+        if (! result.is_amount())
+          throw_(amount_error,
+                 _("Amount expressions must result in a simple amount"));
+        post_amount = result.as_amount();
+      }
+    } else {
+      post_amount = post->amount;
+    }
+
+    amount_t amt;
+    if (! post_amount.commodity())
+      amt = initial_post.amount * post_amount;
+    else
+      amt = post_amount;
+
+#if DEBUG_ON
+    IF_DEBUG("xact.extend") {
+      DEBUG("xact.extend",
+            "Initial post on line " << initial_post.pos->beg_line << ": "
+            << "amount " << initial_post.amount << " (precision "
+            << initial_post.amount.precision() << ")");
+
+      if (initial_post.amount.keep_precision())
+        DEBUG("xact.extend", "  precision is kept");
+
+      DEBUG("xact.extend",
+            "Posting on line " << post->pos->beg_line << ": "
+            << "amount " << post_amount << ", amt " << amt
+            << " (precision " << post_amount.precision()
+            << " != " << amt.precision() << ")");
+
+      if (post_amount.keep_precision())
+        DEBUG("xact.extend", "  precision is kept");
+      if (amt.keep_precision())
+        DEBUG("xact.extend", "  amt precision is kept");
+    }
+#endif // DEBUG_ON
+
+    account_t * account  = post->account;
+    string fullname = account->fullname();
+    assert(! fullname.empty());
+
+    if (contains(fullname, "$account")) {
+      fullname = regex_replace(fullname, regex("\\$account\\>"),
+                               initial_post.account->fullname());
+      while (account->parent)
+        account = account->parent;
+      account = account->find_account(fullname);
+    }
+    else if (contains(fullname, "%(")) {
+      format_t account_name(fullname);
+      std::ostringstream buf;
+      buf << account_name(bound_scope);
+      while (account->parent)
+        account = account->parent;
+      account = account->find_account(buf.str());
+    }
+
+    // Copy over details so that the resulting post is a mirror of
+    // the automated xact's one.
+    post_t * new_post = new post_t(account, amt);
+    new_post->copy_details(*post);
+
+    // A Cleared transaction implies all of its automatic posting are cleared
+    // CPR 2012/10/23
+    if (xact.state() == item_t::CLEARED) {
+      DEBUG("xact.extend.cleared", "CLEARED");
+      new_post->set_state(item_t::CLEARED);
+    }
+
+    new_post->add_flags(ITEM_GENERATED);
+    new_post->account =
+      journal->register_account(account->fullname(), new_post,
+                                journal->master);
+
+    if (deferred_notes) {
+      foreach (deferred_tag_data_t& data, *deferred_notes) {
+        if (! data.apply_to_post || data.apply_to_post == post) {
+          new_post->append_note(
+            apply_format(data.tag_data, bound_scope).c_str(),
+            bound_scope, data.overwrite_existing);
+        }
+      }
+    }
+
+    extend_post(*new_post, *journal);
+
+    xact.add_post(new_post);
+    new_post->account->add_post(new_post);
+
+    if (new_post->must_balance())
+      needs_further_verification = true;
+  }
+
+  return needs_further_verification;
+}
+
 void auto_xact_t::extend_xact(xact_base_t& xact, parse_context_t& context)
 {
   posts_list initial_posts(xact.posts.begin(), xact.posts.end());
@@ -680,137 +824,32 @@ void auto_xact_t::extend_xact(xact_base_t& xact, parse_context_t& context)
       matches_predicate = predicate(bound_scope);
     }
 
-    if (matches_predicate) {
-      if (deferred_notes) {
-        foreach (deferred_tag_data_t& data, *deferred_notes) {
-          if (data.apply_to_post == NULL)
-            initial_post->append_note(
-              apply_format(data.tag_data, bound_scope).c_str(),
-              bound_scope, data.overwrite_existing);
-        }
-      }
-
-      if (check_exprs) {
-        foreach (expr_t::check_expr_pair& pair, *check_exprs) {
-          if (pair.second == expr_t::EXPR_GENERAL) {
-            pair.first.calc(bound_scope);
-          }
-          else if (! pair.first.calc(bound_scope).to_boolean()) {
-            if (pair.second == expr_t::EXPR_ASSERTION)
-              throw_(parse_error,
-                     _f("Transaction assertion failed: %1%") % pair.first);
-            else
-              context.warning(_f("Transaction check failed: %1%") % pair.first);
-          }
-        }
-      }
-
-      foreach (post_t * post, posts) {
-        amount_t post_amount;
-        if (post->amount.is_null()) {
-          if (! post->amount_expr)
-            throw_(amount_error,
-                   _("Automated transaction's posting has no amount"));
-
-          value_t result(post->amount_expr->calc(bound_scope));
-          if (result.is_long()) {
-            post_amount = result.to_amount();
-          } else {
-            if (! result.is_amount())
-              throw_(amount_error,
-                     _("Amount expressions must result in a simple amount"));
-            post_amount = result.as_amount();
-          }
-        } else {
-          post_amount = post->amount;
-        }
-
-        amount_t amt;
-        if (! post_amount.commodity())
-          amt = initial_post->amount * post_amount;
-        else
-          amt = post_amount;
-
-#if DEBUG_ON
-        IF_DEBUG("xact.extend") {
-          DEBUG("xact.extend",
-                "Initial post on line " << initial_post->pos->beg_line << ": "
-                << "amount " << initial_post->amount << " (precision "
-                << initial_post->amount.precision() << ")");
-
-          if (initial_post->amount.keep_precision())
-            DEBUG("xact.extend", "  precision is kept");
-
-          DEBUG("xact.extend",
-                "Posting on line " << post->pos->beg_line << ": "
-                << "amount " << post_amount << ", amt " << amt
-                << " (precision " << post_amount.precision()
-                << " != " << amt.precision() << ")");
-
-          if (post_amount.keep_precision())
-            DEBUG("xact.extend", "  precision is kept");
-          if (amt.keep_precision())
-            DEBUG("xact.extend", "  amt precision is kept");
-        }
-#endif // DEBUG_ON
-
-        account_t * account  = post->account;
-        string fullname = account->fullname();
-        assert(! fullname.empty());
-
-        if (contains(fullname, "$account")) {
-          fullname = regex_replace(fullname, regex("\\$account\\>"),
-                                   initial_post->account->fullname());
-          while (account->parent)
-            account = account->parent;
-          account = account->find_account(fullname);
-        }
-        else if (contains(fullname, "%(")) {
-          format_t account_name(fullname);
-          std::ostringstream buf;
-          buf << account_name(bound_scope);
-          while (account->parent)
-            account = account->parent;
-          account = account->find_account(buf.str());
-        }
-
-        // Copy over details so that the resulting post is a mirror of
-        // the automated xact's one.
-        post_t * new_post = new post_t(account, amt);
-        new_post->copy_details(*post);
+    if (matches_predicate &&
+        apply_to_post(xact, *initial_post, context))
+      needs_further_verification = true;
+  }
 
-        // A Cleared transaction implies all of its automatic posting are cleared
-        // CPR 2012/10/23
-        if (xact.state() == item_t::CLEARED) {
-          DEBUG("xact.extend.cleared", "CLEARED");
-          new_post->set_state(item_t::CLEARED);
-        }
+  if (needs_further_verification)
+    xact.verify();
 
-        new_post->add_flags(ITEM_GENERATED);
-        new_post->account =
-          journal->register_account(account->fullname(), new_post,
-                                    journal->master);
-
-        if (deferred_notes) {
-          foreach (deferred_tag_data_t& data, *deferred_notes) {
-            if (! data.apply_to_post || data.apply_to_post == post) {
-              new_post->append_note(
-                apply_format(data.tag_data, bound_scope).c_str(),
-                bound_scope, data.overwrite_existing);
-            }
-          }
-        }
+  }
+  catch (const std::exception&) {
+    add_error_context(item_context(*this, _("While applying automated transaction")));
+    add_error_context(item_context(xact, _("While extending transaction")));
+    throw;
+  }
+}
 
-        extend_post(*new_post, *journal);
+void auto_xact_t::apply_to_posts(xact_base_t& xact, parse_context_t& context,
+                                 const posts_list& matching_posts)
+{
+  try {
 
-        xact.add_post(new_post);
-        new_post->account->add_post(new_post);
+  bool needs_further_verification = false;
 
-        if (new_post->must_balance())
-          needs_further_verification = true;
-      }
-    }
-  }
+  foreach (post_t * initial_post, matching_posts)
+    if (apply_to_post(xact, *initial_post, context))
+      needs_further_verification = true;
 
   if (needs_further_verification)
     xact.verify();
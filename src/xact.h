@@ -192,7 +192,19 @@ public:
     deferred_notes->back().apply_to_post = active_post;
   }
 
+  // Whether the predicate matches POST, judging by its account alone.
+  // Throws if the predicate looks at anything other than the account.
+  bool quick_match(post_t& post);
+
   virtual void extend_xact(xact_base_t& xact, parse_context_t& context);
+
+  // Like extend_xact, for postings already known to match.
+  void apply_to_posts(xact_base_t& xact, parse_context_t& context,
+                      const posts_list& matching_posts);
+
+private:
+  bool apply_to_post(xact_base_t& xact, post_t& initial_post,
+                     parse_context_t& context);
 };
 
 class period_xact_t : public xact_base_t
@@ -0,0 +1,196 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# This script generates journals of a given number of postings with the
+# generate command, using fixed seeds so that every run sees the same
+# data, and then times a set of common reports against each of them.
+# The results are written as JSON, so that runs against different
+# builds can be compared.
+
+from __future__ import print_function
+
+import sys
+import re
+import os
+import json
+import time
+import argparse
+
+from os.path import *
+from subprocess import Popen, PIPE, check_call
+
+# Average number of postings the generate command makes per transaction.
+POSTINGS_PER_XACT = 5
+
+BENCHMARKS = [
+    ('parse',   ['stats']),
+    ('bal',     ['balance']),
+    ('reg',     ['register']),
+    ('value',   ['balance', '--market']),
+    ('monthly', ['register', '--monthly']),
+    ('sort',    ['register', '--sort', 'payee']),
+    ('print',   ['print']),
+]
+
+class Benchmarks:
+  def __init__(self, args):
+    self.ledger      = abspath(args.ledger)
+    self.work_dir    = abspath(args.work_dir)
+    self.sizes       = args.sizes
+    self.seed        = args.seed
+    self.accounts    = args.accounts
+    self.commodities = args.commodities
+    self.prices      = args.prices
+    self.repeat      = args.repeat
+    self.only        = args.only
+    self.output      = args.output
+
+  def ledger_command(self, journal, args):
+    return [self.ledger, '--args-only', '--columns=80', '-f', journal] + args
+
+  def version(self):
+    proc = Popen([self.ledger, '--args-only', '--version'], stdout=PIPE)
+    out = proc.communicate()[0].decode('utf-8')
+    return out.splitlines()[0] if out else ''
+
+  def generate(self, size):
+    journal = join(self.work_dir, 'bench-%d.dat' % size)
+    xacts = max(1, size // POSTINGS_PER_XACT)
+    command = [self.ledger, '--args-only', '-f', '/dev/null', 'generate',
+               '--seed', str(self.seed), '--head', str(xacts),
+               '--generate-accounts', str(self.accounts),
+               '--generate-commodities', str(self.commodities),
+               '--generate-prices', str(self.prices)]
+
+    start = time.time()
+    with open(journal, 'w') as out:
+      check_call(command, stdout=out)
+    elapsed = time.time() - start
+
+    return journal, elapsed
+
+  def count_postings(self, journal):
+    proc = Popen(self.ledger_command(journal, ['stats']), stdout=PIPE)
+    out = proc.communicate()[0].decode('utf-8')
+    match = re.search(r'Number of postings:\s+(\d+)', out)
+    return int(match.group(1)) if match else 0
+
+  def time_command(self, journal, args):
+    runs = []
+    with open(os.devnull, 'w') as null:
+      for i in range(self.repeat):
+        start = time.time()
+        check_call(self.ledger_command(journal, args), stdout=null)
+        runs.append(time.time() - start)
+    return {
+      'command': ' '.join(args),
+      'runs':    runs,
+      'best':    min(runs),
+      'mean':    sum(runs) / len(runs)
+    }
+
+  def main(self):
+    if not isdir(self.work_dir):
+      os.makedirs(self.work_dir)
+
+    results = {
+      'ledger':      self.ledger,
+      'version':     self.version(),
+      'seed':        self.seed,
+      'accounts':    self.accounts,
+      'commodities': self.commodities,
+      'prices':      self.prices,
+      'repeat':      self.repeat,
+      'journals':    []
+    }
+
+    for size in self.sizes:
+      journal, generate_time = self.generate(size)
+      entry = {
+        'requested_postings': size,
+        'postings':           self.count_postings(journal),
+        'bytes':              getsize(journal),
+        'generate_seconds':   generate_time,
+        'benchmarks':         {}
+      }
+      for name, args in BENCHMARKS:
+        if self.only and name not in self.only:
+          continue
+        result = self.time_command(journal, args)
+        entry['benchmarks'][name] = result
+        print('%10d %-8s %8.3fs' % (entry['postings'], name, result['best']),
+              file=sys.stderr)
+      results['journals'].append(entry)
+
+    text = json.dumps(results, indent=2, sort_keys=True)
+    if self.output:
+      with open(self.output, 'w') as out:
+        out.write(text + '\n')
+    else:
+      print(text)
+    return 0
+
+if __name__ == "__main__":
+  def getargs():
+    parser = argparse.ArgumentParser(prog='Benchmarks',
+            description='Time ledger reports against generated journals')
+    parser.add_argument('-l', '--ledger',
+        dest='ledger',
+        type=str,
+        action='store',
+        required=True,
+        help='the path to the ledger executable to benchmark')
+    parser.add_argument('-w', '--work-dir',
+        dest='work_dir',
+        type=str,
+        action='store',
+        default='bench',
+        help='where to write the generated journals')
+    parser.add_argument('-o', '--output',
+        dest='output',
+        type=str,
+        action='store',
+        help='write the JSON results to this file rather than stdout')
+    parser.add_argument('--sizes',
+        dest='sizes',
+        type=int,
+        nargs='+',
+        default=[10000],
+        help='approximate number of postings in each generated journal')
+    parser.add_argument('--seed',
+        dest='seed',
+        type=int,
+        default=1,
+        help='the random seed passed to the generate command')
+    parser.add_argument('--accounts',
+        dest='accounts',
+        type=int,
+        default=200,
+        help='how many distinct accounts the journals use')
+    parser.add_argument('--commodities',
+        dest='commodities',
+        type=int,
+        default=10,
+        help='how many distinct commodities the journals use')
+    parser.add_argument('--prices',
+        dest='prices',
+        type=int,
+        default=10,
+        help='percentage of postings which are given a cost')
+    parser.add_argument('-r', '--repeat',
+        dest='repeat',
+        type=int,
+        default=3,
+        help='how many times to run each benchmark')
+    parser.add_argument('--only',
+        dest='only',
+        type=str,
+        nargs='+',
+        help='run only the named benchmarks (%s)'
+             % ', '.join(name for name, args in BENCHMARKS))
+    return parser.parse_args()
+
+  args = getargs()
+  script = Benchmarks(args)
+  status = script.main()
+  sys.exit(status)
@@ -24,6 +24,9 @@ class CheckBaselineTests (CheckOptions):
         'debug',
         'download',
         'force-pager',
+        'generate-accounts',
+        'generate-commodities',
+        'generate-prices',
         'generated',
         'help',
         'import',
@@ -33,6 +36,7 @@ class CheckBaselineTests (CheckOptions):
         'price-exp',
         'revalued-total',
         'seed',
+        'socket',
         'trace',
         'verbose',
         'verify',
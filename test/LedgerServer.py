@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+from __future__ import print_function
+
+import os
+import signal
+import socket
+import time
+
+from subprocess import Popen
+
+class LedgerServer:
+  """A ledger server answering one command line per connection."""
+
+  def __init__(self, ledger, socket_path, args, log_path=os.devnull):
+    self.socket_path = socket_path
+    self.log = open(log_path, 'w')
+    self.process = Popen([ledger, '--args-only',
+                          '--socket', socket_path] + args + ['server'],
+                         stdout=self.log, stderr=self.log)
+
+    # The socket only appears once the journal has been read.
+    for attempt in range(500):
+      if os.path.exists(socket_path) or self.process.poll() is not None:
+        break
+      time.sleep(0.01)
+    if not os.path.exists(socket_path):
+      self.stop()
+      raise RuntimeError('ledger server did not start')
+
+  def send(self, command):
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    client.settimeout(60)
+    client.connect(self.socket_path)
+    client.sendall((command + '\n').encode('utf-8'))
+    chunks = []
+    while True:
+      chunk = client.recv(4096)
+      if not chunk:
+        break
+      chunks.append(chunk)
+    client.close()
+    return b''.join(chunks).decode('utf-8')
+
+  def stop(self):
+    # The server stops on SIGINT, removing its socket as it goes.
+    if self.process.poll() is None:
+      self.process.send_signal(signal.SIGINT)
+      self.process.wait()
+    self.log.close()
@@ -0,0 +1,137 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+from __future__ import print_function
+
+import sys
+import os
+import shutil
+import tempfile
+import argparse
+
+from LedgerServer import LedgerServer
+
+APPENDED_MESSAGE = 'Reading what was appended to'
+
+class ReloadTests:
+  """Check that reload reads only what was appended to a journal, and
+  reads it all again whenever that would give a different journal."""
+
+  def __init__(self, args):
+    self.ledger  = os.path.abspath(args.ledger)
+    self.workdir = tempfile.mkdtemp(prefix='ledger-reload-')
+    self.failed  = 0
+
+  def write(self, name, text, mode='w'):
+    with open(os.path.join(self.workdir, name), mode) as journal:
+      journal.write(text)
+
+  def check(self, name, initial, changed, command, expected, appended):
+    """Serve a journal holding INITIAL, change it by calling CHANGED, and
+    reload.  COMMAND must then give EXPECTED, and the appended text must
+    have been read on its own exactly when APPENDED is true."""
+    journal  = os.path.join(self.workdir, name + '.dat')
+    log_path = os.path.join(self.workdir, name + '.log')
+    self.write(name + '.dat', initial)
+
+    server = LedgerServer(self.ledger, os.path.join(self.workdir, 'socket'),
+                          ['--verbose', '-f', journal], log_path)
+    try:
+      server.send(command)
+      changed(name + '.dat')
+      server.send('reload')
+      output = server.send(command)
+    finally:
+      server.stop()
+
+    with open(log_path) as log:
+      resumed = APPENDED_MESSAGE in log.read()
+
+    if output != expected:
+      print('FAILED: %s' % name)
+      print('Expected:\n%sGot:\n%s' % (expected, output))
+      self.failed += 1
+    elif resumed != appended:
+      print('FAILED: %s: appended text was %sread on its own' %
+            (name, '' if resumed else 'not '))
+      self.failed += 1
+
+  def main(self):
+    def append(text):
+      return lambda name: self.write(name, text, 'a')
+
+    # Text appended after a complete transaction is read on its own.
+    self.check('appended', '''2012/01/01 Opening
+    Assets:Cash          10
+    Equity
+''', append('''
+2012/01/02 Lunch
+    Expenses:Food         3
+    Assets:Cash
+'''), 'bal Assets', '''                   7  Assets:Cash
+''', True)
+
+    # A year directive still applies to whatever follows it, so the file
+    # must be read again from the start.
+    self.check('year', '''year 2011
+
+01/01 Opening
+    Assets:Cash          10
+    Equity
+''', append('''
+01/02 Lunch
+    Expenses:Food         3
+    Assets:Cash
+'''), 'reg --columns=80 Expenses', '''11-Jan-02 Lunch                 Expenses:Food                     3            3
+''', False)
+
+    # So does an apply block left open at the end of the file.
+    self.check('apply', '''apply account Home
+
+2012/01/01 Opening
+    Assets:Cash          10
+    Equity
+''', append('''
+2012/01/02 Lunch
+    Expenses:Food         3
+    Assets:Cash
+'''), 'bal Expenses', '''                   3  Home:Expenses:Food
+''', False)
+
+    # A file that was changed before its old end, and not only appended
+    # to, is read again from the start.
+    def rewrite(name):
+      self.write(name, '''2012/01/01 Opening
+    Assets:Cash          20
+    Equity
+
+2012/01/02 Lunch
+    Expenses:Food         3
+    Assets:Cash
+''')
+
+    self.check('changed', '''2012/01/01 Opening
+    Assets:Cash          10
+    Equity
+''', rewrite, 'bal Assets', '''                  17  Assets:Cash
+''', False)
+
+    shutil.rmtree(self.workdir)
+    return self.failed
+
+if __name__ == '__main__':
+  def getargs():
+    parser = argparse.ArgumentParser(prog='ReloadTests',
+            description='Check that reload reads appended journal text')
+    parser.add_argument('-l', '--ledger',
+        dest='ledger',
+        type=str,
+        action='store',
+        required=True,
+        help='the path to the ledger executable to test with')
+    return parser.parse_args()
+
+  args = getargs()
+  script = ReloadTests(args)
+  status = script.main()
+  sys.exit(status)
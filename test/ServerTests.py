@@ -0,0 +1,102 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+from __future__ import print_function
+
+import sys
+import os
+import shutil
+import socket
+import tempfile
+import argparse
+
+from LedgerServer import LedgerServer
+
+class ServerTests:
+  """Check that a ledger server answers its clients one command at a
+  time, and that no client can stop it answering the next one."""
+
+  def __init__(self, args):
+    self.ledger  = os.path.abspath(args.ledger)
+    self.workdir = tempfile.mkdtemp(prefix='ledger-server-')
+    self.failed  = 0
+
+  def expect(self, what, output, expected):
+    if output != expected:
+      print('FAILED: %s' % what)
+      print('Expected:\n%sGot:\n%s' % (expected, output))
+      self.failed += 1
+
+  def main(self):
+    journal = os.path.join(self.workdir, 'server.dat')
+    with open(journal, 'w') as out:
+      out.write('''2012/01/01 Opening
+    Assets:Cash          10
+    Equity
+
+2012/01/02 Lunch
+    Expenses:Food         3
+    Assets:Cash
+''')
+      # Enough postings that their register does not fit in the socket's
+      # buffers, for a client that never reads it.
+      for day in range(1, 29):
+        for count in range(100):
+          out.write('''
+2013/02/%02d Coffee
+    Expenses:Food         1
+    Assets:Cash
+''' % day)
+
+    socket_path = os.path.join(self.workdir, 'socket')
+    server = LedgerServer(self.ledger, socket_path, ['-f', journal])
+    try:
+      self.expect('round trip', server.send('bal Equity --columns=80'),
+                  '''                 -10  Equity
+''')
+
+      self.expect('error', server.send('bal --no-such-option'),
+                  '''Error: Illegal option --no-such-option
+''')
+
+      self.expect('nested server', server.send('server'),
+                  '''Error: Unrecognized command 'server'
+''')
+
+      # A client that asks for a long report and never reads it is dropped
+      # once writing to it times out.
+      stalled = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+      stalled.connect(socket_path)
+      stalled.sendall(b'reg --columns=400\n')
+
+      self.expect('after a stalled client',
+                  server.send('bal Equity --columns=80'),
+                  '''                 -10  Equity
+''')
+      stalled.close()
+    finally:
+      server.stop()
+
+    if os.path.exists(socket_path):
+      print('FAILED: the server left its socket behind')
+      self.failed += 1
+
+    shutil.rmtree(self.workdir)
+    return self.failed
+
+if __name__ == '__main__':
+  def getargs():
+    parser = argparse.ArgumentParser(prog='ServerTests',
+            description='Check that ledger serves reports over a socket')
+    parser.add_argument('-l', '--ledger',
+        dest='ledger',
+        type=str,
+        action='store',
+        required=True,
+        help='the path to the ledger executable to test with')
+    return parser.parse_args()
+
+  args = getargs()
+  script = ServerTests(args)
+  status = script.main()
+  sys.exit(status)
@@ -6,6 +6,7 @@
 
 #include "amount.h"
 #include "commodity.h"
+#include "value.h"
 
 #define internalAmount(x) amount_t::exact(x)
 
@@ -1388,6 +1389,132 @@ BOOST_AUTO_TEST_CASE(testCommodityPrinting)
   BOOST_CHECK(x2.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testParseFromCharacters)
+{
+  amount_t    x1;
+  amount_t    x2;
+  std::size_t consumed;
+
+  const char * s1 = "10 USD ; note";
+  BOOST_CHECK(x1.parse(s1, std::strlen(s1), consumed));
+  BOOST_CHECK_EQUAL(std::size_t(6), consumed);
+  x2.parse(std::string("10 USD"));
+  BOOST_CHECK_EQUAL(x2, x1);
+
+  const char * s2 = "$10.00 @ $1";
+  BOOST_CHECK(x1.parse(s2, std::strlen(s2), consumed));
+  BOOST_CHECK_EQUAL(std::size_t(6), consumed);
+  BOOST_CHECK_EQUAL(amount_t("$10.00"), x1);
+
+  const char * s3 = "-5.5 EUR";
+  BOOST_CHECK(x1.parse(s3, std::strlen(s3), consumed));
+  BOOST_CHECK_EQUAL(std::strlen(s3), consumed);
+  BOOST_CHECK_EQUAL(amount_t("-5.5 EUR"), x1);
+
+  // Only the given number of characters is looked at.
+  const char * s4 = "12 ABCDEF";
+  BOOST_CHECK(x1.parse(s4, 5, consumed));
+  BOOST_CHECK_EQUAL(std::size_t(5), consumed);
+  BOOST_CHECK_EQUAL(amount_t("12 AB"), x1);
+
+  // Quoted commodities and annotations take the stream parser's path.
+  const char * s5 = "1 \"A B\" {$2} @ $3";
+  BOOST_CHECK(x1.parse(s5, std::strlen(s5), consumed));
+  BOOST_CHECK_EQUAL(std::size_t(12), consumed);
+  std::istringstream in(s5);
+  x2.parse(in);
+  BOOST_CHECK_EQUAL(x2, x1);
+
+  BOOST_CHECK(x1.valid());
+  BOOST_CHECK(x2.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testSmallQuantityPromotion)
+{
+  // These quantities all fit in 64 bits as parsed, but not every result
+  // computed from them does.
+  amount_t x1("999999999999999999");
+  amount_t x2("0.999999999999999999");
+  amount_t x3("$0.01");
+
+  BOOST_CHECK_EQUAL(amount_t("1999999999999999998"), x1 + x1);
+  BOOST_CHECK_EQUAL(amount_t("-1999999999999999998"), - x1 - x1);
+  BOOST_CHECK_EQUAL(amount_t("999999999999999998000000000000000001"), x1 * x1);
+  BOOST_CHECK_EQUAL(amount_t("999999999999999999.999999999999999999"), x1 + x2);
+  BOOST_CHECK(x1 < x1 + x2);
+  BOOST_CHECK(x1 + x2 > x1);
+
+  BOOST_CHECK_EQUAL(amount_t("2.5"), amount_t("10.00") / amount_t(4L));
+  BOOST_CHECK_EQUAL(amount_t(1L), amount_t(1L) / amount_t(3L) * amount_t(3L));
+  BOOST_CHECK_EQUAL(amount_t("0.12"), amount_t("0.1") + amount_t("0.02"));
+
+  BOOST_CHECK((x3 * amount_t("0.4")).is_zero());
+  BOOST_CHECK(! (x3 * amount_t("0.4")).is_realzero());
+  BOOST_CHECK(! (x3 * amount_t("0.6")).is_zero());
+
+  BOOST_CHECK(x1.valid());
+  BOOST_CHECK(x2.valid());
+  BOOST_CHECK(x3.valid());
+}
+
+BOOST_AUTO_TEST_CASE(testConcurrentArithmetic)
+{
+  value_t::initialize();
+
+  // The threads below start from copies of the same amounts, so they
+  // share quantities, and work on them at the same time.  Each must get
+  // the same results as the main thread does on its own.
+  const amount_t dollars("$1234.56");
+  const amount_t cent("$0.01");
+  const amount_t euros("EUR 0.333");
+  const amount_t big("12345678901234567890.123456789");
+
+  auto work = [&]() {
+    std::ostringstream out;
+    amount_t  sum(dollars);
+    balance_t bal;
+    value_t   val;
+
+    for (int i = 0; i < 200; i++) {
+      sum += dollars;
+      sum -= cent;
+
+      amount_t q(big);
+      q *= euros;
+      q /= amount_t(7L);
+      q.in_place_roundto(i % 10);
+
+      bal += sum;
+      bal += q;
+      bal -= euros;
+
+      val += value_t(q);
+      value_t less(sum.number() < q.number());
+
+      out << sum.to_fullstring() << ' ' << q.to_fullstring() << ' '
+          << q.truncated() << ' ' << q.floored() << ' ' << q.to_double()
+          << ' ' << q.is_zero() << ' ' << (q == big) << ' ' << less << '\n';
+    }
+    bal.print(out);
+    val.print(out);
+    return out.str();
+  };
+
+  const string expected = work();
+
+  std::vector<string> results(4);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < results.size(); i++)
+    threads.push_back(std::thread([&, i]() { results[i] = work(); }));
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (const string& result : results)
+    BOOST_CHECK_EQUAL(expected, result);
+
+  value_t::shutdown();
+}
+
 #endif // NOT_FOR_PYTHON
 
 BOOST_AUTO_TEST_SUITE_END()
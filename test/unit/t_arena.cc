@@ -0,0 +1,77 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include "arena.h"
+
+using namespace ledger;
+
+namespace {
+  struct widest_t : public arena_object_t
+  {
+    static int live;
+
+    std::max_align_t value;
+
+    widest_t() {
+      live++;
+    }
+    ~widest_t() {
+      live--;
+    }
+  };
+
+  int widest_t::live = 0;
+
+  bool aligned(const void * ptr) {
+    return reinterpret_cast<std::size_t>(ptr) %
+      alignof(std::max_align_t) == 0;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(arena)
+
+BOOST_AUTO_TEST_CASE(testAlignment)
+{
+  // Objects must be aligned as ::operator new would align them, whether
+  // they come from the heap or an arena, and whatever came before them.
+  arena_t arena(1024);
+  arena.allocate(1, 1);
+
+  std::vector<widest_t *> objects;
+  for (int i = 0; i < 100; i++) {
+    objects.push_back(new widest_t);
+    objects.push_back(new (arena) widest_t);
+    arena.allocate(static_cast<std::size_t>(i % 7), 1);
+  }
+  foreach (widest_t * object, objects)
+    BOOST_CHECK(aligned(object));
+
+  foreach (widest_t * object, objects)
+    checked_delete(object);
+  BOOST_CHECK_EQUAL(0, widest_t::live);
+}
+
+BOOST_AUTO_TEST_CASE(testDestruction)
+{
+  arena_t arena;
+
+  // Deleting an object placed in an arena runs its destructor, and
+  // leaves its storage for the arena; this is what happens when a
+  // parser's unique_ptr gives up a posting it could not finish.
+  {
+    unique_ptr<widest_t> object(new (arena) widest_t);
+    BOOST_CHECK_EQUAL(1, widest_t::live);
+  }
+  BOOST_CHECK_EQUAL(0, widest_t::live);
+
+  widest_t * heap_object  = new widest_t;
+  widest_t * arena_object = new (arena) widest_t;
+  BOOST_CHECK_EQUAL(2, widest_t::live);
+  checked_delete(arena_object);
+  checked_delete(heap_object);
+  BOOST_CHECK_EQUAL(0, widest_t::live);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
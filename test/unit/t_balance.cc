@@ -525,4 +525,73 @@ BOOST_AUTO_TEST_CASE(testForZero)
   BOOST_CHECK(b1.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testManyCommodities)
+{
+  // More commodities than a balance keeps inline, added in an order
+  // unrelated to how their amounts are stored.
+  const char * symbols[] = { "EUR", "GBP", "JPY", "CHF", "CAD", "AUD", "$" };
+
+  balance_t b0;
+  balance_t b1;
+
+  for (int i = 6; i >= 0; i--) {
+    b0 += amount_t(string("1.00 ") + symbols[i]);
+    b1 -= amount_t(string("2.00 ") + symbols[(i * 3) % 7]);
+  }
+
+  BOOST_CHECK_EQUAL(7U, b0.commodity_count());
+  BOOST_CHECK_EQUAL(7U, b1.commodity_count());
+
+  balance_t b2(b1);
+  b2 += b0;
+  b2 += b0;
+  BOOST_CHECK(b2.is_zero());
+
+  b2 = b0;
+  b2 -= b0;
+  BOOST_CHECK(b2.is_empty());
+
+  b2 = b0;
+  b2 -= amount_t("1.00 JPY");
+  b2 -= amount_t("1.00 AUD");
+  BOOST_CHECK_EQUAL(5U, b2.commodity_count());
+  BOOST_CHECK(! b2.commodity_amount(amount_t("1.00 JPY").commodity()));
+  BOOST_CHECK_EQUAL(amount_t("1.00 CAD"),
+                    *b2.commodity_amount(amount_t("1.00 CAD").commodity()));
+
+  b2 += amount_t("3.00 JPY");
+  BOOST_CHECK_EQUAL(6U, b2.commodity_count());
+  BOOST_CHECK_EQUAL(b0 + amount_t("2.00 JPY") - amount_t("1.00 AUD"), b2);
+
+  // Enough commodities that the amounts no longer fit in a small vector.
+  balance_t b3;
+  for (int i = 0; i < 40; i++)
+    b3 += amount_t(string("1.00 C") + char('A' + i % 26) + char('A' + i / 26));
+
+  BOOST_CHECK_EQUAL(40U, b3.commodity_count());
+  BOOST_CHECK_EQUAL(b3, balance_t(b3));
+
+  for (int i = 0; i < 40; i += 2)
+    b3 -= amount_t(string("1.00 C") + char('A' + i % 26) + char('A' + i / 26));
+
+  BOOST_CHECK_EQUAL(20U, b3.commodity_count());
+  BOOST_CHECK(! b3.commodity_amount(amount_t("1.00 CAA").commodity()));
+  BOOST_CHECK_EQUAL(amount_t("1.00 CBA"),
+                    *b3.commodity_amount(amount_t("1.00 CBA").commodity()));
+
+  const commodity_t * last = NULL;
+  foreach (const balance_t::amounts_map::value_type& pair, b3.amounts) {
+    BOOST_CHECK(std::less<const commodity_t *>()(last, pair.first));
+    last = pair.first;
+  }
+
+  b3 -= balance_t(b3);
+  BOOST_CHECK(b3.is_empty());
+
+  BOOST_CHECK(b0.valid());
+  BOOST_CHECK(b1.valid());
+  BOOST_CHECK(b2.valid());
+  BOOST_CHECK(b3.valid());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
 
 #include "amount.h"
 #include "commodity.h"
+#include "pool.h"
 
 using namespace ledger;
 
@@ -111,5 +112,45 @@ BOOST_AUTO_TEST_CASE(testPriceHistory)
   BOOST_CHECK(x1.valid());
 }
 
+BOOST_AUTO_TEST_CASE(testRememberedPrices)
+{
+  datetime_t jan01_12 = parse_datetime("2012/01/01 00:00:00");
+  datetime_t feb01_12 = parse_datetime("2012/02/01 00:00:00");
+  datetime_t mar01_12 = parse_datetime("2012/03/01 00:00:00");
+
+  amount_t x1("10 QQQ");
+  amount_t one_pound("GBP 1.00");
+  amount_t one_dollar("$1.00");
+
+  commodity_t& qqq(x1.commodity());
+  commodity_t& pound(one_pound.commodity());
+  commodity_t& dollar(one_dollar.commodity());
+
+  qqq.add_price(jan01_12, amount_t("GBP 2.00"));
+  pound.add_price(jan01_12, amount_t("$1.50"));
+
+  commodity_pool_t& pool(*commodity_pool_t::current_pool);
+  std::size_t cached = pool.price_lookups_cached;
+
+  optional<amount_t> amt = x1.value(mar01_12, &dollar);
+  BOOST_CHECK(amt);
+  BOOST_CHECK_EQUAL(amount_t("$30.00"), *amt);
+
+  amt = x1.value(mar01_12, &dollar);
+  BOOST_CHECK(amt);
+  BOOST_CHECK_EQUAL(amount_t("$30.00"), *amt);
+  BOOST_CHECK_EQUAL(cached + 1, std::size_t(pool.price_lookups_cached));
+
+  // A new price for the pound changes the value of QQQ in dollars, even
+  // though no price was given for QQQ itself.
+  pound.add_price(feb01_12, amount_t("$2.00"));
+
+  amt = x1.value(mar01_12, &dollar);
+  BOOST_CHECK(amt);
+  BOOST_CHECK_EQUAL(amount_t("$40.00"), *amt);
+  BOOST_CHECK_EQUAL(cached + 1, std::size_t(pool.price_lookups_cached));
+
+  BOOST_CHECK(x1.valid());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
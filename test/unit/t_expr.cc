@@ -8,9 +8,17 @@
 #include "predicate.h"
 #include "query.h"
 #include "op.h"
+#include "program.h"
+#include "scope.h"
 
 using namespace ledger;
 
+namespace {
+  value_t get_seven(call_scope_t&) {
+    return 7L;
+  }
+}
+
 struct expr_fixture {
   expr_fixture() {
     times_initialize();
@@ -331,4 +339,40 @@ BOOST_AUTO_TEST_CASE(testPredicateTokenizer16)
 #endif
 }
 
+BOOST_AUTO_TEST_CASE(testProgramMatchesTree)
+{
+  symbol_scope_t scope;
+  scope.define(symbol_t::FUNCTION, "x", WRAP_FUNCTOR(&get_seven));
+
+  const char * exprs[] = {
+    "x * 2 + 1",
+    "x - 10 / 4",
+    "-x",
+    "!(x == 7)",
+    "x > 5 ? x : -x",
+    "x < 5 ? x : -x",
+    "x < 5 & x",
+    "x > 5 & x",
+    "x < 5 | 3",
+    "x > 5 | 3",
+    "x >= 7 & x <= 7 & x != 8",
+    "x =~ /^7$/",
+    "(x + 1) * (x - 1) / (x + x)"
+  };
+
+  foreach (const char * text, exprs) {
+    expr_t expr(text);
+    value_t tree_result(expr.calc(scope));
+
+    expr_t::ptr_op_t op(expr.get_op());
+    shared_ptr<expr_t::program_t> program(expr_t::program_t::lower(op));
+    BOOST_REQUIRE_MESSAGE(program, text);
+    BOOST_CHECK_EQUAL(tree_result, program->run(scope));
+
+    // The second evaluation goes through the lowered program.
+    BOOST_CHECK_EQUAL(tree_result, expr.calc(scope));
+    BOOST_CHECK_EQUAL(tree_result, expr.calc(scope));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,47 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include "item.h"
+
+using namespace ledger;
+
+BOOST_AUTO_TEST_SUITE(item)
+
+BOOST_AUTO_TEST_CASE(testTagMapOrder)
+{
+  tag_names_t names;
+  tag_map_t   tags(names);
+  tags.insert("zeta", tag_map_t::data_type(value_t(1L), false));
+  tags.insert("Alpha", tag_map_t::data_type(value_t(2L), false));
+  tags.insert("beta", tag_map_t::data_type(value_t(3L), false));
+  tags.insert("apple", tag_map_t::data_type(none, false));
+
+  // Another spelling of a tag already present is the same tag.
+  std::pair<tag_map_t::iterator, bool> result =
+    tags.insert("ALPHA", tag_map_t::data_type(value_t(4L), false));
+  BOOST_CHECK(! result.second);
+  BOOST_CHECK_EQUAL(string("Alpha"), (*result.first).first.str());
+  BOOST_CHECK_EQUAL(4U, tags.size());
+
+  // Tags are kept in the order of their names regardless of case.
+  const char * order[] = { "Alpha", "apple", "beta", "zeta" };
+  std::size_t  index   = 0;
+  foreach (const tag_map_t::value_type& data, tags)
+    BOOST_CHECK_EQUAL(string(order[index++]), data.first.str());
+
+  BOOST_CHECK(tags.find("alpha") != tags.end());
+  BOOST_CHECK(tags.find("BETA") != tags.end());
+  BOOST_CHECK(tags.find("gamma") == tags.end());
+  BOOST_CHECK(names.find_key("never-given-to-an-item") ==
+              tag_name_t::no_key);
+
+  // Every spelling of a name shares one key, but keeps its own entry.
+  tag_name_t later(names.intern("Given-Later"));
+  BOOST_CHECK_EQUAL(later.key(), names.find_key("given-later"));
+  BOOST_CHECK_EQUAL(later.key(), names.intern("GIVEN-LATER").key());
+  BOOST_CHECK_EQUAL(string("GIVEN-LATER"), names.intern("GIVEN-LATER").str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <system.hh>
+
+#include "journal.h"
+#include "account.h"
+#include "xact.h"
+#include "post.h"
+#include "session.h"
+#include "report.h"
+#include "archive.h"
+
+using namespace ledger;
+
+namespace {
+  struct counted_post_t : public post_t
+  {
+    static int live;
+
+    counted_post_t(account_t * account) : post_t(account) {
+      live++;
+    }
+    ~counted_post_t() {
+      live--;
+    }
+  };
+
+  int counted_post_t::live = 0;
+}
+
+struct journal_fixture {
+  journal_fixture() {
+    times_initialize();
+  }
+  ~journal_fixture() {
+    times_shutdown();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(journal, journal_fixture)
+
+BOOST_AUTO_TEST_CASE(testFindAccountAfterRemove)
+{
+  journal_t journal;
+
+  account_t * cash = journal.find_account("Assets:Cash");
+  BOOST_CHECK_EQUAL(cash, journal.find_account("Assets:Cash"));
+
+  // Once Assets is removed, the name must not still find the account
+  // remembered under it.
+  account_t * assets = journal.find_account("Assets");
+  BOOST_CHECK(journal.remove_account(assets));
+
+  account_t * new_cash = journal.find_account("Assets:Cash");
+  BOOST_CHECK(new_cash != cash);
+  BOOST_CHECK(new_cash->parent != assets);
+  BOOST_CHECK_EQUAL(string("Assets:Cash"), new_cash->fullname());
+
+  checked_delete(assets);
+}
+
+BOOST_AUTO_TEST_CASE(testExpandAliasesAfterRemove)
+{
+  journal_t journal;
+
+  account_t * cash = journal.find_account("Assets:Cash");
+  journal.account_aliases.insert(accounts_map::value_type("Cash", cash));
+  BOOST_CHECK_EQUAL(cash, journal.expand_aliases("Cash"));
+
+  // Removing an account forgets every expansion, since one may have led
+  // to it; here the alias is then pointed elsewhere.
+  account_t * assets = journal.find_account("Assets");
+  journal.remove_account(assets);
+
+  account_t * wallet = journal.find_account("Liabilities:Wallet");
+  journal.account_aliases["Cash"] = wallet;
+  BOOST_CHECK_EQUAL(wallet, journal.expand_aliases("Cash"));
+
+  checked_delete(assets);
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyArenaPosts)
+{
+  unique_ptr<journal_t> journal(new journal_t);
+  account_t * cash = journal->find_account("Assets:Cash");
+
+  // The journal's destructor empties every account's postings before
+  // deleting its transactions, which must still destroy each posting,
+  // whether it lives in the journal's arena or on the heap.
+  xact_t * xact = new (journal->arena) xact_t;
+  for (int i = 0; i < 4; i++) {
+    post_t * post = i % 2 ? new counted_post_t(cash)
+                          : new (journal->arena) counted_post_t(cash);
+    xact->add_post(post);
+    cash->add_post(post);
+  }
+  journal->xacts.push_back(xact);
+  BOOST_CHECK_EQUAL(4, counted_post_t::live);
+
+  journal.reset();
+  BOOST_CHECK_EQUAL(0, counted_post_t::live);
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyArchivedJournal)
+{
+  path dir(filesystem::temp_directory_path() /
+           filesystem::unique_path("ledger-journal-%%%%-%%%%"));
+  filesystem::create_directories(dir);
+  path journal_path(dir / "journal.dat");
+  path archive_path(dir / "journal.cache");
+  {
+    ofstream out(journal_path);
+    out << "2012/01/01 Opening\n"
+        << "    Assets:Cash                               10\n"
+        << "    Equity\n"
+        << "\n"
+        << "2012/01/02 Lunch\n"
+        << "    Expenses:Food                              3\n"
+        << "    Assets:Cash\n";
+  }
+
+  {
+    session_t session;
+    set_session_context(&session);
+    report_t report(session);
+    scope_t::default_scope = &report;
+
+    archive_t(archive_path, "test").save(*session.read_journal(journal_path));
+
+    // The archive reader places what it reads in the new journal's arena;
+    // destroying that journal must destroy all of it.
+    unique_ptr<journal_t> loaded(new journal_t);
+    archive_t archive(archive_path, "test");
+    BOOST_REQUIRE(archive.should_load());
+    archive.load(*loaded);
+
+    BOOST_CHECK_EQUAL(2U, loaded->xacts.size());
+    account_t * cash = loaded->find_account("Assets:Cash", false);
+    BOOST_REQUIRE(cash != NULL);
+    BOOST_CHECK_EQUAL(2U, cash->posts.size());
+    foreach (post_t * post, cash->posts)
+      BOOST_CHECK(post->account == cash);
+
+    loaded.reset();
+    scope_t::default_scope = NULL;
+    set_session_context(NULL);
+  }
+
+  filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
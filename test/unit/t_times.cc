@@ -166,4 +166,24 @@ BOOST_AUTO_TEST_CASE(testConstructors)
 #endif
 }
 
+BOOST_AUTO_TEST_CASE(testParseDateForms)
+{
+  date_t d1(2006, 1, 5);
+
+  BOOST_CHECK_EQUAL(d1, parse_date("2006/01/05"));
+  BOOST_CHECK_EQUAL(d1, parse_date("2006/1/5"));
+  BOOST_CHECK_EQUAL(d1, parse_date("2006-01-05"));
+  BOOST_CHECK_EQUAL(d1, parse_date("2006.1.05"));
+
+  date_t d2 = parse_date("1/5");
+  BOOST_CHECK_EQUAL(d2, parse_date("01-05"));
+  BOOST_CHECK_EQUAL(d2.month(), 1);
+  BOOST_CHECK_EQUAL(d2.day(), 5);
+
+  BOOST_CHECK_THROW(parse_date("2006/12/25x"), date_error);
+  BOOST_CHECK_THROW(parse_date("2006/012/25"), date_error);
+  BOOST_CHECK_THROW(parse_date("2007/02/29"),
+                    boost::gregorian::bad_day_of_month);
+}
+
 BOOST_AUTO_TEST_SUITE_END()